@@ -0,0 +1,150 @@
+/**
+ * @file LoggerBenchmark.ino
+ * @brief Measures Logger::log() latency with several contending producer tasks.
+ *
+ * Each run starts N producer tasks (alternately pinned to both cores) that
+ * log CALLS_PER_TASK formatted messages while timing every call with the CPU
+ * cycle counter. The merged samples are sorted and p50/p99 are printed.
+ * Producers never wait for each other; "dropped" counts entries overwritten
+ * before they were read, "busy" entries that found the ring full of records
+ * other producers were still writing.
+ *
+ * The export benchmark then fills the buffer and times draining it with a
+ * getNextLogJson() loop against a single exportLogs() call into a buffer.
+ *
+ * The format benchmark compares snprintf with BraceFormat::format on the
+ * same message, without logging, in cycles per call.
+ *
+ * Build without -DENABLE_SERIAL_PRINT, otherwise the UART dominates the numbers.
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <vector>
+#include "ESPLogger.h"
+
+static constexpr size_t CALLS_PER_TASK = 500;
+static constexpr size_t PRODUCER_COUNTS[] = {1, 2, 4, 8};
+static constexpr size_t EXPORT_ENTRIES = 64;
+static constexpr size_t FORMAT_CALLS = 2000;
+
+static char exportBuffer[16384];
+
+struct ProducerContext {
+    uint32_t* samples;
+    SemaphoreHandle_t done;
+    int id;
+};
+
+static void producerTask(void* parameter) {
+    ProducerContext* ctx = static_cast<ProducerContext*>(parameter);
+    Logger& logger = Logger::instance();
+
+    for (size_t i = 0; i < CALLS_PER_TASK; ++i) {
+        uint32_t start = ESP.getCycleCount();
+        logger.log("Bench", Logger::Level::INFO, "producer %d iteration %u", ctx->id, static_cast<unsigned>(i));
+        ctx->samples[i] = ESP.getCycleCount() - start;
+    }
+
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void runBenchmark(size_t producers) {
+    std::vector<uint32_t> samples(producers * CALLS_PER_TASK);
+    std::vector<ProducerContext> contexts(producers);
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(producers, 0);
+
+    for (size_t i = 0; i < producers; ++i) {
+        contexts[i] = {samples.data() + i * CALLS_PER_TASK, done, static_cast<int>(i)};
+        xTaskCreatePinnedToCore(producerTask, "LogBench", 4096, &contexts[i], 1, NULL, i % 2);
+    }
+    for (size_t i = 0; i < producers; ++i) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+    vSemaphoreDelete(done);
+
+    std::sort(samples.begin(), samples.end());
+    const float cyclesPerNs = ESP.getCpuFreqMHz() / 1000.0f;
+    uint32_t p50 = samples[samples.size() / 2];
+    uint32_t p99 = samples[samples.size() * 99 / 100];
+    Serial.printf("producers=%u p50_ns=%.0f p99_ns=%.0f dropped=%u busy=%u\n",
+                  static_cast<unsigned>(producers), p50 / cyclesPerNs, p99 / cyclesPerNs,
+                  static_cast<unsigned>(Logger::instance().getDroppedCount()),
+                  static_cast<unsigned>(Logger::instance().getBusyDroppedCount()));
+}
+
+static void fillForExport() {
+    Logger& logger = Logger::instance();
+    Logger::LogEntry entry;
+    while (logger.getNextLog(entry)) {
+        // Discard what the latency runs left behind
+    }
+    for (size_t i = 0; i < EXPORT_ENTRIES; ++i) {
+        logger.log("Bench", Logger::Level::INFO, "export entry %u", static_cast<unsigned>(i));
+    }
+}
+
+static void runExportBenchmark() {
+    Logger& logger = Logger::instance();
+
+    fillForExport();
+    size_t loopEntries = 0;
+    size_t loopBytes = 0;
+    int64_t start = esp_timer_get_time();
+    for (String json = logger.getNextLogJson(); !json.isEmpty(); json = logger.getNextLogJson()) {
+        loopBytes += json.length();
+        ++loopEntries;
+    }
+    int64_t loopTime = esp_timer_get_time() - start;
+
+    fillForExport();
+    size_t bulkBytes = 0;
+    start = esp_timer_get_time();
+    size_t bulkEntries = logger.exportLogs(exportBuffer, sizeof(exportBuffer), bulkBytes);
+    int64_t bulkTime = esp_timer_get_time() - start;
+
+    Serial.printf("export loop_us=%lld entries=%u bytes=%u\n", static_cast<long long>(loopTime),
+                  static_cast<unsigned>(loopEntries), static_cast<unsigned>(loopBytes));
+    Serial.printf("export bulk_us=%lld entries=%u bytes=%u\n", static_cast<long long>(bulkTime),
+                  static_cast<unsigned>(bulkEntries), static_cast<unsigned>(bulkBytes));
+}
+
+static void runFormatBenchmark() {
+    char text[LOGGER_MESSAGE_SIZE];
+    const IPAddress ip(192, 168, 1, 20);
+    size_t length = 0;
+
+    uint32_t start = ESP.getCycleCount();
+    for (size_t i = 0; i < FORMAT_CALLS; ++i) {
+        length += snprintf(text, sizeof(text), "t=%u h=%.2f ip=%u.%u.%u.%u s=%s", static_cast<unsigned>(i),
+                           21.5f + i % 7, ip[0], ip[1], ip[2], ip[3], "ok");
+    }
+    uint32_t printfCycles = ESP.getCycleCount() - start;
+
+    start = ESP.getCycleCount();
+    for (size_t i = 0; i < FORMAT_CALLS; ++i) {
+        length += BraceFormat::format(text, sizeof(text), "t={} h={} ip={} s={}", static_cast<unsigned>(i),
+                                      21.5f + i % 7, ip, "ok");
+    }
+    uint32_t braceCycles = ESP.getCycleCount() - start;
+
+    Serial.printf("format snprintf_cycles=%u brace_cycles=%u chars=%u\n",
+                  static_cast<unsigned>(printfCycles / FORMAT_CALLS), static_cast<unsigned>(braceCycles / FORMAT_CALLS),
+                  static_cast<unsigned>(length));
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(1000);
+
+    for (size_t producers : PRODUCER_COUNTS) {
+        runBenchmark(producers);
+    }
+    runExportBenchmark();
+    runFormatBenchmark();
+}
+
+void loop() {
+    vTaskDelay(portMAX_DELAY);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file MQTTLatency.ino
+ * @brief Measures how quickly ESPMQTTManager delivers inbound messages.
+ *
+ * The sketch subscribes to a topic, then publishes ROUNDS messages to that
+ * same topic, one at a time. Each payload carries its send time, and the
+ * subscription callback records how long the broker round trip and the
+ * manager's receive path took. p50/p99/max are printed in milliseconds:
+ *
+ *   mqtt_latency rounds=100 received=100 p50_ms=41.3 p99_ms=88.0 max_ms=97.2
+ *
+ * The round trip includes the network and broker, so compare runs against
+ * the same broker. Set the WiFi and broker settings below before flashing.
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <vector>
+#include "ESPWifi.h"
+#include "MQTTManager.h"
+
+static constexpr const char* WIFI_SSID = "your-ssid";
+static constexpr const char* WIFI_PASSWORD = "your-password";
+static constexpr const char* TOPIC = "esp-utils/latency";
+static constexpr size_t ROUNDS = 100;
+static constexpr uint32_t ROUND_TIMEOUT_MS = 5000;
+
+static ESPMQTTManager::Config mqttConfig = {
+    "broker.example.com", 8883, "user", "password", nullptr, nullptr, nullptr, "random",
+};
+
+static WiFiWrapper wifi(WIFI_SSID, WIFI_PASSWORD);
+static ESPMQTTManager mqttManager(mqttConfig);
+
+static SemaphoreHandle_t received;
+static volatile int64_t roundTripUs;
+
+static void onMessage(char* topic, byte* payload, unsigned int length) {
+    char text[24];
+    length = std::min<unsigned int>(length, sizeof(text) - 1);
+    memcpy(text, payload, length);
+    text[length] = '\0';
+    roundTripUs = esp_timer_get_time() - strtoll(text, nullptr, 10);
+    xSemaphoreGive(received);
+}
+
+static void runLatency() {
+    std::vector<float> samples;
+    samples.reserve(ROUNDS);
+    char payload[24];
+
+    for (size_t i = 0; i < ROUNDS; ++i) {
+        snprintf(payload, sizeof(payload), "%lld", static_cast<long long>(esp_timer_get_time()));
+        mqttManager.publish(TOPIC, payload);
+        if (xSemaphoreTake(received, pdMS_TO_TICKS(ROUND_TIMEOUT_MS)) == pdTRUE) {
+            samples.push_back(roundTripUs / 1000.0f);
+        }
+    }
+
+    if (samples.empty()) {
+        Serial.printf("mqtt_latency rounds=%u received=0\n", static_cast<unsigned>(ROUNDS));
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    Serial.printf("mqtt_latency rounds=%u received=%u p50_ms=%.1f p99_ms=%.1f max_ms=%.1f\n",
+                  static_cast<unsigned>(ROUNDS), static_cast<unsigned>(samples.size()), samples[samples.size() / 2],
+                  samples[samples.size() * 99 / 100], samples.back());
+}
+
+void setup() {
+    Serial.begin(115200);
+    received = xSemaphoreCreateBinary();
+
+    wifi.begin();
+    mqttManager.setCallback(onMessage);
+    mqttManager.begin();
+    while (!mqttManager.isConnected()) {
+        delay(100);
+    }
+    mqttManager.subscribe(TOPIC);
+
+    runLatency();
+}
+
+void loop() {
+    delay(1000);
+}
@@ -0,0 +1,152 @@
+#include "ESPBraceFormat.h"
+#include <cmath>
+
+namespace BraceFormat {
+
+namespace {
+
+static constexpr int FRACTION_DIGITS = 6;            ///< Decimals printed for floating point values
+static constexpr uint64_t FRACTION_SCALE = 1000000;  ///< 10^FRACTION_DIGITS
+static constexpr double FIXED_MIN = 1e-5;            ///< Smallest magnitude printed without an exponent
+static constexpr double FIXED_MAX = 1e15;            ///< Largest magnitude printed without an exponent
+
+/**
+ * @brief Print an integer part and a rounded, trimmed fraction.
+ * @param writer Destination.
+ * @param value Non-negative value below FIXED_MAX.
+ */
+void writeFixed(Writer& writer, double value) {
+    uint64_t whole = static_cast<uint64_t>(value);
+    uint64_t fraction = static_cast<uint64_t>((value - static_cast<double>(whole)) * FRACTION_SCALE + 0.5);
+    if (fraction >= FRACTION_SCALE) {
+        ++whole;
+        fraction -= FRACTION_SCALE;
+    }
+
+    writeUnsigned(writer, whole);
+    if (fraction == 0) {
+        return;
+    }
+
+    char digits[FRACTION_DIGITS];
+    int count = FRACTION_DIGITS;
+    for (int i = FRACTION_DIGITS - 1; i >= 0; --i) {
+        digits[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    while (count > 0 && digits[count - 1] == '0') {
+        --count;
+    }
+    writer.put('.');
+    writer.append(digits, count);
+}
+
+} // namespace
+
+void Writer::append(const char* text, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        put(text[i]);
+    }
+}
+
+void writeUnsigned(Writer& writer, uint64_t value) {
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[sizeof(digits) - ++count] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    writer.append(digits + sizeof(digits) - count, count);
+}
+
+void writeSigned(Writer& writer, int64_t value) {
+    if (value < 0) {
+        writer.put('-');
+        // Negate in unsigned arithmetic so INT64_MIN does not overflow
+        writeUnsigned(writer, 0 - static_cast<uint64_t>(value));
+    } else {
+        writeUnsigned(writer, static_cast<uint64_t>(value));
+    }
+}
+
+void writeDouble(Writer& writer, double value) {
+    if (std::isnan(value)) {
+        writer.append("nan", 3);
+        return;
+    }
+    if (std::signbit(value)) {
+        writer.put('-');
+        value = -value;
+    }
+    if (std::isinf(value)) {
+        writer.append("inf", 3);
+        return;
+    }
+
+    if (value == 0.0 || (value >= FIXED_MIN && value < FIXED_MAX)) {
+        writeFixed(writer, value);
+        return;
+    }
+
+    // Scale into [1, 10) and print the mantissa with an exponent
+    int exponent = static_cast<int>(std::floor(std::log10(value)));
+    double mantissa = value / std::pow(10.0, exponent);
+    if (mantissa >= 10.0) {
+        mantissa /= 10.0;
+        ++exponent;
+    } else if (mantissa < 1.0) {
+        mantissa *= 10.0;
+        --exponent;
+    }
+    // Rounding to the printed decimals can carry into a new digit, e.g. 9.9999999 -> 10
+    if (std::round(mantissa * FRACTION_SCALE) >= 10.0 * FRACTION_SCALE) {
+        mantissa = 1.0;
+        ++exponent;
+    }
+    writeFixed(writer, mantissa);
+    writer.put('e');
+    writeSigned(writer, exponent);
+}
+
+void writeString(Writer& writer, const char* value) {
+    if (value == nullptr) {
+        value = "(null)";
+    }
+    while (*value != '\0') {
+        writer.put(*value++);
+    }
+}
+
+void writePointer(Writer& writer, const void* value) {
+    static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+    uintptr_t bits = reinterpret_cast<uintptr_t>(value);
+    char digits[2 * sizeof(uintptr_t)];
+    size_t count = 0;
+    do {
+        digits[sizeof(digits) - ++count] = HEX_DIGITS[bits & 0x0F];
+        bits >>= 4;
+    } while (bits != 0);
+    writer.append("0x", 2);
+    writer.append(digits + sizeof(digits) - count, count);
+}
+
+void formatErased(Writer& writer, const char* format, const void* const* values, const ArgWriter* writers, size_t count) {
+    size_t next = 0;
+    for (const char* p = format; *p != '\0'; ++p) {
+        if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}')) {
+            writer.put(*p++);
+        } else if (p[0] == '{' && p[1] == '}') {
+            if (next < count) {
+                writers[next](writer, values[next]);
+                ++next;
+            } else {
+                writer.append("{}", 2);
+            }
+            ++p;
+        } else {
+            writer.put(*p);
+        }
+    }
+}
+
+} // namespace BraceFormat
@@ -0,0 +1,185 @@
+/**
+ * @file ESPBraceFormat.h
+ * @brief Type-safe "{}" formatting without printf.
+ *
+ * Every "{}" in the format string is replaced by the next argument,
+ * formatted according to its C++ type, so there are no conversion
+ * specifiers to get wrong. "{{" and "}}" produce literal braces. Integers,
+ * floating point values, booleans, characters, strings, pointers and (on
+ * Arduino) String and IPAddress are supported; other types fail to compile.
+ *
+ * countPlaceholders() is constexpr, so the LOGGER_FMT macros check that a
+ * literal format string has exactly as many placeholders as arguments at
+ * compile time. Placeholders without an argument are kept as "{}".
+ *
+ * Numbers are converted with integer arithmetic only; floating point values
+ * are printed with up to six decimals, or in exponent form outside
+ * [1e-5, 1e15).
+ */
+
+#ifndef ESP_BRACE_FORMAT_H
+#define ESP_BRACE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <IPAddress.h>
+#endif
+
+namespace BraceFormat {
+
+static constexpr size_t INVALID_FORMAT = SIZE_MAX; ///< Returned by countPlaceholders for a malformed format
+
+/**
+ * @brief Count the "{}" placeholders of a format string.
+ * @param format Format string.
+ * @return Number of placeholders, or INVALID_FORMAT if a brace is not part of "{}", "{{" or "}}".
+ */
+constexpr size_t countPlaceholders(const char* format) {
+    size_t count = 0;
+    for (const char* p = format; *p != '\0'; ++p) {
+        if (*p == '{') {
+            if (p[1] == '{') {
+                ++p;
+            } else if (p[1] == '}') {
+                ++count;
+                ++p;
+            } else {
+                return INVALID_FORMAT;
+            }
+        } else if (*p == '}') {
+            if (p[1] != '}') {
+                return INVALID_FORMAT;
+            }
+            ++p;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Count arguments in an unevaluated context, e.g. decltype(countArgs(a, b))::value.
+ */
+template<typename... Args>
+std::integral_constant<size_t, sizeof...(Args)> countArgs(const Args&...);
+
+/**
+ * @class Writer
+ * @brief Bounds-checked output buffer, always null-terminated.
+ */
+class Writer {
+public:
+    Writer(char* out, size_t size) : out(out), size(size), position(0) {
+        if (size > 0) {
+            out[0] = '\0';
+        }
+    }
+
+    void put(char c) {
+        if (position + 1 < size) {
+            out[position++] = c;
+            out[position] = '\0';
+        }
+    }
+
+    void append(const char* text, size_t length);
+
+    size_t length() const { return position; }
+
+private:
+    char* out;
+    size_t size;
+    size_t position;
+};
+
+void writeSigned(Writer& writer, int64_t value);
+void writeUnsigned(Writer& writer, uint64_t value);
+void writeDouble(Writer& writer, double value);
+void writeString(Writer& writer, const char* value);
+void writePointer(Writer& writer, const void* value);
+
+/**
+ * @brief Append one argument according to its type.
+ * @param writer Destination.
+ * @param value Argument to format.
+ */
+template<typename T>
+void writeValue(Writer& writer, const T& value) {
+    using Type = std::decay_t<T>;
+    if constexpr (std::is_same_v<Type, bool>) {
+        writeString(writer, value ? "true" : "false");
+    } else if constexpr (std::is_same_v<Type, char>) {
+        writer.put(value);
+    } else if constexpr (std::is_same_v<Type, char*> || std::is_same_v<Type, const char*>) {
+        writeString(writer, value);
+    } else if constexpr (std::is_same_v<Type, std::string_view> || std::is_same_v<Type, std::string>) {
+        writer.append(value.data(), value.length());
+#ifdef ARDUINO
+    } else if constexpr (std::is_same_v<Type, String>) {
+        writer.append(value.c_str(), value.length());
+    } else if constexpr (std::is_same_v<Type, IPAddress>) {
+        for (int i = 0; i < 4; ++i) {
+            if (i > 0) {
+                writer.put('.');
+            }
+            writeUnsigned(writer, value[i]);
+        }
+#endif
+    } else if constexpr (std::is_enum_v<Type>) {
+        writeValue(writer, static_cast<std::underlying_type_t<Type>>(value));
+    } else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+        writeSigned(writer, value);
+    } else if constexpr (std::is_integral_v<Type>) {
+        writeUnsigned(writer, value);
+    } else if constexpr (std::is_floating_point_v<Type>) {
+        writeDouble(writer, static_cast<double>(value));
+    } else if constexpr (std::is_pointer_v<Type> || std::is_null_pointer_v<Type>) {
+        writePointer(writer, value);
+    } else {
+        static_assert(std::is_pointer_v<Type>, "Unsupported format argument type");
+    }
+}
+
+using ArgWriter = void (*)(Writer&, const void*); ///< Formats one type-erased argument
+
+template<typename T>
+void writeErased(Writer& writer, const void* value) {
+    writeValue(writer, *static_cast<const T*>(value));
+}
+
+/**
+ * @brief Expand a format string with type-erased arguments.
+ * @param writer Destination.
+ * @param format Format string.
+ * @param values Addresses of the arguments.
+ * @param writers Formatter of each argument.
+ * @param count Number of arguments.
+ */
+void formatErased(Writer& writer, const char* format, const void* const* values, const ArgWriter* writers, size_t count);
+
+/**
+ * @brief Format arguments into a buffer.
+ * @param out Destination buffer, always null-terminated when size > 0.
+ * @param size Size of the destination buffer.
+ * @param format Format string with "{}" placeholders.
+ * @param args Arguments, one per placeholder.
+ * @return Number of characters written, excluding the terminator.
+ */
+template<typename... Args>
+size_t format(char* out, size_t size, const char* format, const Args&... args) {
+    Writer writer(out, size);
+    // The extra element keeps the arrays valid when there are no arguments
+    const void* values[] = {static_cast<const void*>(&args)..., nullptr};
+    const ArgWriter writers[] = {&writeErased<Args>..., nullptr};
+    formatErased(writer, format, values, writers, sizeof...(Args));
+    return writer.length();
+}
+
+} // namespace BraceFormat
+
+#endif // ESP_BRACE_FORMAT_H
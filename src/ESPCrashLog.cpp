@@ -0,0 +1,135 @@
+#include "ESPCrashLog.h"
+#include "ESPCrc32.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+
+namespace {
+
+constexpr uint32_t CRASH_LOG_MAGIC = 0x474C5243; // "CRLG"
+
+struct CrashSlot {
+    ESPCrashLog::Entry entry;
+    uint32_t crc;
+};
+
+struct CrashRing {
+    uint32_t magic;
+    CrashSlot slots[ESPCrashLog::ENTRY_COUNT];
+};
+
+// Not initialized at startup, so the previous boot's contents are still there in begin()
+RTC_NOINIT_ATTR CrashRing crashRing;
+
+} // namespace
+
+ESPCrashLog& ESPCrashLog::instance() {
+    static ESPCrashLog instance;
+    return instance;
+}
+
+ESPCrashLog::ESPCrashLog()
+    : previousCount(0),
+      nextSequence(0),
+      started(false) {}
+
+void ESPCrashLog::begin() {
+    if (started) {
+        return;
+    }
+
+    previousCount = 0;
+    if (crashRing.magic == CRASH_LOG_MAGIC) {
+        for (const CrashSlot& slot : crashRing.slots) {
+            if (slot.crc == slotCrc(slot.entry)) {
+                previous[previousCount++] = slot.entry;
+            }
+        }
+
+        // Slots are reused in a ring, so restore logging order
+        for (size_t i = 1; i < previousCount; ++i) {
+            Entry entry = previous[i];
+            size_t j = i;
+            while (j > 0 && previous[j - 1].sequence > entry.sequence) {
+                previous[j] = previous[j - 1];
+                --j;
+            }
+            previous[j] = entry;
+        }
+    }
+
+    memset(&crashRing, 0, sizeof(crashRing));
+    crashRing.magic = CRASH_LOG_MAGIC;
+    nextSequence = 0;
+    started = true;
+
+    Logger::instance().setMirror(this);
+    LOGGER_INFO("CrashLog", "Reset reason: %s, recovered %u entries", getResetReason(), static_cast<unsigned>(previousCount));
+}
+
+void ESPCrashLog::mirror(const char* tag, Logger::Level level, const char* message) {
+    Entry entry;
+    memset(&entry, 0, sizeof(entry)); // Padding is part of the CRC
+    entry.timestamp = esp_timer_get_time();
+    entry.level = level;
+    strncpy(entry.tag, tag, TAG_SIZE - 1);
+    strncpy(entry.message, message, MESSAGE_SIZE - 1);
+
+    portENTER_CRITICAL(&lock);
+    entry.sequence = nextSequence++;
+    portEXIT_CRITICAL(&lock);
+
+    uint32_t crc = slotCrc(entry);
+    CrashSlot& slot = crashRing.slots[entry.sequence % ENTRY_COUNT];
+
+    portENTER_CRITICAL(&lock);
+    // Invalidate first, so a reset in the middle of the copy leaves a slot that fails validation
+    slot.crc = 0;
+    memcpy(&slot.entry, &entry, sizeof(entry));
+    slot.crc = crc;
+    portEXIT_CRITICAL(&lock);
+}
+
+size_t ESPCrashLog::getPreviousBootCount() const {
+    return previousCount;
+}
+
+const ESPCrashLog::Entry* ESPCrashLog::getPreviousBootEntry(size_t index) const {
+    return index < previousCount ? &previous[index] : nullptr;
+}
+
+String ESPCrashLog::getPreviousBootJson(size_t index) const {
+    const Entry* entry = getPreviousBootEntry(index);
+    if (entry == nullptr) {
+        return String("");
+    }
+
+    JsonDocument doc;
+    doc["tag"] = entry->tag;
+    doc["level"] = static_cast<int>(entry->level);
+    doc["timestamp_us"] = entry->timestamp;
+    doc["message"] = entry->message;
+
+    String jsonString;
+    serializeJson(doc, jsonString);
+    return jsonString;
+}
+
+const char* ESPCrashLog::getResetReason() const {
+    switch (esp_reset_reason()) {
+        case ESP_RST_POWERON: return "POWERON";
+        case ESP_RST_EXT: return "EXTERNAL";
+        case ESP_RST_SW: return "SOFTWARE";
+        case ESP_RST_PANIC: return "PANIC";
+        case ESP_RST_INT_WDT: return "INTERRUPT_WDT";
+        case ESP_RST_TASK_WDT: return "TASK_WDT";
+        case ESP_RST_WDT: return "WDT";
+        case ESP_RST_DEEPSLEEP: return "DEEPSLEEP";
+        case ESP_RST_BROWNOUT: return "BROWNOUT";
+        case ESP_RST_SDIO: return "SDIO";
+        default: return "UNKNOWN";
+    }
+}
+
+uint32_t ESPCrashLog::slotCrc(const Entry& entry) {
+    return crc32(&entry, sizeof(entry));
+}
@@ -0,0 +1,113 @@
+/**
+ * @file ESPCrashLog.h
+ * @brief Last log entries kept in RTC memory across soft resets.
+ *
+ * ESPCrashLog mirrors every stored entry into a small ring placed in
+ * RTC_NOINIT memory, which keeps its contents through panics, watchdog
+ * resets and esp_restart(). On the next boot begin() validates each slot
+ * against a magic number and CRC, keeps the valid ones as the previous
+ * boot's tail and starts a fresh ring. The tail can then be published,
+ * e.g. with ESPTelemetry::publishCrashLog().
+ *
+ * Contents are lost on power-on and brownout resets, where RTC memory is
+ * not retained; the persistent file sink covers those.
+ */
+
+#ifndef ESP_CRASH_LOG_H
+#define ESP_CRASH_LOG_H
+
+#include <cstdint>
+#include "ESPLogger.h"
+
+#ifndef LOGGER_CRASH_LOG_ENTRIES
+#define LOGGER_CRASH_LOG_ENTRIES 16 ///< Number of entries kept in RTC memory
+#endif
+
+#ifndef LOGGER_CRASH_LOG_MESSAGE_SIZE
+#define LOGGER_CRASH_LOG_MESSAGE_SIZE 96 ///< Maximum size of a message kept in RTC memory
+#endif
+
+/**
+ * @class ESPCrashLog
+ * @brief Logger mirror keeping the last entries in RTC memory for the next boot.
+ */
+class ESPCrashLog : public Logger::Mirror {
+public:
+    static constexpr size_t ENTRY_COUNT = LOGGER_CRASH_LOG_ENTRIES; ///< Number of entries kept
+    static constexpr size_t MESSAGE_SIZE = LOGGER_CRASH_LOG_MESSAGE_SIZE; ///< Maximum size of a kept message
+    static constexpr size_t TAG_SIZE = 16; ///< Maximum size of a kept tag
+
+    /**
+     * @struct Entry
+     * @brief Entry as stored in RTC memory.
+     */
+    struct Entry {
+        uint32_t sequence;         ///< Order of the entry within its boot
+        int64_t timestamp;         ///< Microseconds since that boot
+        Logger::Level level;       ///< Severity level
+        char tag[TAG_SIZE];        ///< Tag, truncated
+        char message[MESSAGE_SIZE]; ///< Message, truncated
+    };
+
+    /**
+     * @brief Get the singleton instance of the crash log.
+     * @return Reference to the crash log.
+     */
+    static ESPCrashLog& instance();
+
+    /**
+     * @brief Recover the previous boot's entries and start mirroring the Logger.
+     *
+     * Call early in setup(), before the entries of this boot overwrite the ring.
+     */
+    void begin();
+
+    /**
+     * @brief Store an entry in RTC memory.
+     * @param tag Tag of the entry.
+     * @param level Severity level of the entry.
+     * @param message Formatted message of the entry.
+     */
+    void mirror(const char* tag, Logger::Level level, const char* message) override;
+
+    /**
+     * @brief Get the number of entries recovered from the previous boot.
+     * @return Number of valid entries, 0 after a power-on reset.
+     */
+    size_t getPreviousBootCount() const;
+
+    /**
+     * @brief Get a recovered entry.
+     * @param index Index from the oldest recovered entry.
+     * @return Pointer to the entry, or nullptr if index is out of range.
+     */
+    const Entry* getPreviousBootEntry(size_t index) const;
+
+    /**
+     * @brief Get a recovered entry as a JSON object.
+     * @param index Index from the oldest recovered entry.
+     * @return JSON string representation of the entry, or empty string if index is out of range.
+     */
+    String getPreviousBootJson(size_t index) const;
+
+    /**
+     * @brief Get the reason of the last reset.
+     * @return Printable reset reason.
+     */
+    const char* getResetReason() const;
+
+private:
+    ESPCrashLog();
+    ESPCrashLog(const ESPCrashLog&) = delete;
+    ESPCrashLog& operator=(const ESPCrashLog&) = delete;
+
+    static uint32_t slotCrc(const Entry& entry);
+
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    Entry previous[ENTRY_COUNT];
+    size_t previousCount;
+    uint32_t nextSequence;
+    bool started;
+};
+
+#endif // ESP_CRASH_LOG_H
@@ -0,0 +1,37 @@
+/**
+ * @file ESPCrc32.h
+ * @brief CRC-32 (IEEE 802.3) used to validate persisted log and queue data.
+ *
+ * Uses a 16-entry table to keep flash usage small. Has no Arduino
+ * dependencies so host tools can validate the same data.
+ */
+
+#ifndef ESP_CRC32_H
+#define ESP_CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Compute or continue a CRC-32.
+ * @param data Bytes to checksum.
+ * @param length Number of bytes.
+ * @param crc CRC of the preceding bytes when checksumming in pieces, 0 to start.
+ * @return CRC-32 of all bytes so far.
+ */
+inline uint32_t crc32(const void* data, size_t length, uint32_t crc = 0) {
+    static constexpr uint32_t TABLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = TABLE[(crc ^ bytes[i]) & 0x0F] ^ (crc >> 4);
+        crc = TABLE[(crc ^ (bytes[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+#endif // ESP_CRC32_H
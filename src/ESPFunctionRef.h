@@ -0,0 +1,91 @@
+/**
+ * @file ESPFunctionRef.h
+ * @brief Non-owning reference to a callable, without heap allocation.
+ *
+ * FunctionRef stores either a plain function pointer or the address of a
+ * callable object, plus a pointer to a small thunk that invokes it. It is
+ * two pointers wide and never allocates. Captureless lambdas are stored as
+ * function pointers, so they may be passed as temporaries; any other
+ * callable must be a named object that outlives the reference.
+ */
+
+#ifndef ESP_FUNCTION_REF_H
+#define ESP_FUNCTION_REF_H
+
+#include <type_traits>
+#include <utility>
+
+template<typename Signature>
+class FunctionRef;
+
+/**
+ * @class FunctionRef
+ * @brief Non-owning callable reference with signature R(Args...).
+ */
+template<typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+public:
+    using Function = R (*)(Args...); ///< Plain function pointer type
+
+    /**
+     * @brief Construct an empty reference.
+     */
+    FunctionRef() : invoker(nullptr) {
+        target.object = nullptr;
+    }
+
+    /**
+     * @brief Refer to a function, captureless lambda or callable object.
+     * @param callable Function pointer or lambda convertible to one, or an lvalue callable that outlives the reference.
+     */
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, FunctionRef>>>
+    FunctionRef(F&& callable) {
+        if constexpr (std::is_convertible_v<F, Function>) {
+            target.function = static_cast<Function>(callable);
+            invoker = &callFunction;
+        } else {
+            static_assert(std::is_lvalue_reference_v<F>,
+                          "FunctionRef does not own its target; pass a named callable that outlives it");
+            using Type = std::remove_reference_t<F>;
+            target.object = const_cast<void*>(static_cast<const void*>(&callable));
+            invoker = &callObject<Type>;
+        }
+    }
+
+    /**
+     * @brief Invoke the referenced callable.
+     * @param args Arguments forwarded to the callable.
+     * @return Result of the callable.
+     */
+    R operator()(Args... args) const {
+        return invoker(target, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Check whether the reference is set.
+     * @return true if a callable is referenced.
+     */
+    explicit operator bool() const {
+        return invoker != nullptr;
+    }
+
+private:
+    union Target {
+        void* object;
+        Function function;
+    };
+
+    static R callFunction(Target target, Args... args) {
+        return target.function(std::forward<Args>(args)...);
+    }
+
+    template<typename Type>
+    static R callObject(Target target, Args... args) {
+        return (*static_cast<Type*>(target.object))(std::forward<Args>(args)...);
+    }
+
+    Target target;
+    R (*invoker)(Target, Args...);
+};
+
+#endif // ESP_FUNCTION_REF_H
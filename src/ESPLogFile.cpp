@@ -0,0 +1,284 @@
+#include "ESPLogFile.h"
+#include "ESPCrc32.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LogFile {
+
+void filePath(char* path, size_t size, const char* directory, size_t index) {
+    snprintf(path, size, "%s/log%u.bin", directory, static_cast<unsigned>(index));
+}
+
+} // namespace LogFile
+
+ESPLogFileSink::ESPLogFileSink(const Config& config)
+    : config(config),
+      file(nullptr),
+      fileSize(0),
+      blockEntries(0),
+      blockStarted(0),
+      writeErrors(0) {}
+
+ESPLogFileSink::~ESPLogFileSink() {
+    flush();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+bool ESPLogFileSink::begin() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (mkdir(config.directory, 0755) != 0 && errno != EEXIST) {
+        LOGGER_ERROR("LogFile", "Failed to create log directory %s", config.directory);
+        return false;
+    }
+
+    config.blockSize = std::min(config.blockSize, LogFile::MAX_BLOCK_SIZE);
+    block.reserve(config.blockSize);
+    block.assign(sizeof(LogFile::BlockHeader), 0);
+    return openCurrent();
+}
+
+void ESPLogFileSink::write(const Logger::LogEntry* entries, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (block.empty()) {
+        return; // Not started
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const Logger::LogEntry& entry = entries[i];
+        LogFile::EntryHeader header = {};
+        header.timestamp = entry.timestamp;
+        header.level = static_cast<uint8_t>(entry.level);
+        header.tagLength = static_cast<uint8_t>(strnlen(entry.tag, Logger::TAG_SIZE));
+        header.messageLength = static_cast<uint16_t>(strnlen(entry.message, Logger::LOG_SIZE));
+
+        size_t entrySize = sizeof(header) + header.tagLength + header.messageLength;
+        if (block.size() + entrySize > config.blockSize && blockEntries > 0) {
+            writeBlock();
+        }
+        if (blockEntries == 0) {
+            blockStarted = esp_timer_get_time();
+        }
+
+        const uint8_t* headerBytes = reinterpret_cast<const uint8_t*>(&header);
+        block.insert(block.end(), headerBytes, headerBytes + sizeof(header));
+        block.insert(block.end(), entry.tag, entry.tag + header.tagLength);
+        block.insert(block.end(), entry.message, entry.message + header.messageLength);
+        ++blockEntries;
+    }
+
+    flushIfDue();
+}
+
+void ESPLogFileSink::idle() {
+    std::lock_guard<std::mutex> lock(mutex);
+    flushIfDue();
+}
+
+bool ESPLogFileSink::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return blockEntries == 0 || writeBlock();
+}
+
+size_t ESPLogFileSink::getWriteErrorCount() const {
+    return writeErrors;
+}
+
+bool ESPLogFileSink::writeBlock() {
+    LogFile::BlockHeader header;
+    header.magic = LogFile::BLOCK_MAGIC;
+    header.version = LogFile::FORMAT_VERSION;
+    header.entryCount = blockEntries;
+    header.payloadLength = static_cast<uint32_t>(block.size() - sizeof(header));
+    header.crc = crc32(block.data() + sizeof(header), header.payloadLength);
+    memcpy(block.data(), &header, sizeof(header));
+
+    if (fileSize > 0 && fileSize + block.size() > config.maxFileSize) {
+        rotate();
+    }
+
+    bool written = file != nullptr && fwrite(block.data(), 1, block.size(), file) == block.size() &&
+                   fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (written) {
+        fileSize += block.size();
+    } else {
+        // Logging the failure would come back to this sink, so only count it
+        ++writeErrors;
+    }
+
+    block.resize(sizeof(header));
+    blockEntries = 0;
+    return written;
+}
+
+void ESPLogFileSink::flushIfDue() {
+    if (blockEntries > 0 && esp_timer_get_time() - blockStarted >= static_cast<int64_t>(config.flushInterval) * 1000) {
+        writeBlock();
+    }
+}
+
+bool ESPLogFileSink::rotate() {
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+
+    char from[96];
+    char to[96];
+    LogFile::filePath(to, sizeof(to), config.directory, config.fileCount - 1);
+    remove(to);
+    for (size_t index = config.fileCount - 1; index > 0; --index) {
+        LogFile::filePath(from, sizeof(from), config.directory, index - 1);
+        LogFile::filePath(to, sizeof(to), config.directory, index);
+        rename(from, to);
+    }
+    return openCurrent();
+}
+
+bool ESPLogFileSink::openCurrent() {
+    char path[96];
+    LogFile::filePath(path, sizeof(path), config.directory, 0);
+    file = fopen(path, "ab");
+    if (file == nullptr) {
+        fileSize = 0;
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long position = ftell(file);
+    fileSize = position > 0 ? static_cast<size_t>(position) : 0;
+    return true;
+}
+
+ESPLogFileReader::ESPLogFileReader(const char* directory, size_t fileCount)
+    : directory(directory),
+      fileCount(fileCount),
+      nextFile(fileCount),
+      file(nullptr),
+      blockOffset(0),
+      blockRemaining(0),
+      corruptBlocks(0) {}
+
+ESPLogFileReader::~ESPLogFileReader() {
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+void ESPLogFileReader::rewind() {
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+    nextFile = fileCount;
+    blockRemaining = 0;
+}
+
+size_t ESPLogFileReader::getCorruptBlockCount() const {
+    return corruptBlocks;
+}
+
+bool ESPLogFileReader::next(Logger::LogEntry& entry) {
+    while (blockRemaining == 0) {
+        if (!readBlock()) {
+            return false;
+        }
+    }
+
+    LogFile::EntryHeader header;
+    memcpy(&header, block.data() + blockOffset, sizeof(header));
+    const char* bytes = reinterpret_cast<const char*>(block.data() + blockOffset + sizeof(header));
+
+    size_t tagLength = std::min<size_t>(header.tagLength, Logger::TAG_SIZE - 1);
+    size_t messageLength = std::min<size_t>(header.messageLength, Logger::LOG_SIZE - 1);
+    memcpy(entry.tag, bytes, tagLength);
+    entry.tag[tagLength] = '\0';
+    memcpy(entry.message, bytes + header.tagLength, messageLength);
+    entry.message[messageLength] = '\0';
+    entry.level = static_cast<Logger::Level>(header.level);
+    entry.timestamp = header.timestamp;
+    entry.fieldsLength = 0;
+
+    blockOffset += sizeof(header) + header.tagLength + header.messageLength;
+    --blockRemaining;
+    return true;
+}
+
+bool ESPLogFileReader::openNextFile() {
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+
+    // Files are numbered newest first, so replay from the highest index down
+    while (nextFile > 0) {
+        char path[96];
+        LogFile::filePath(path, sizeof(path), directory, --nextFile);
+        file = fopen(path, "rb");
+        if (file != nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ESPLogFileReader::readBlock() {
+    while (true) {
+        if (file == nullptr && !openNextFile()) {
+            return false;
+        }
+
+        LogFile::BlockHeader header;
+        if (fread(&header, 1, sizeof(header), file) != sizeof(header)) {
+            fclose(file);
+            file = nullptr;
+            continue;
+        }
+
+        // The length comes from flash, so check it before allocating for it
+        struct stat info;
+        long position = ftell(file);
+        bool valid = header.magic == LogFile::BLOCK_MAGIC && header.version == LogFile::FORMAT_VERSION &&
+                     header.payloadLength <= LogFile::MAX_BLOCK_SIZE && position >= 0 &&
+                     fstat(fileno(file), &info) == 0 &&
+                     static_cast<size_t>(position) + header.payloadLength <= static_cast<size_t>(info.st_size);
+        if (valid) {
+            block.resize(header.payloadLength);
+            valid = fread(block.data(), 1, block.size(), file) == block.size() &&
+                    crc32(block.data(), block.size()) == header.crc;
+        }
+        if (!valid) {
+            // A torn or unknown block leaves no reliable way to find the next one in this file
+            ++corruptBlocks;
+            fclose(file);
+            file = nullptr;
+            continue;
+        }
+
+        // Check that the entries stay inside the payload before handing them out
+        size_t offset = 0;
+        for (uint16_t i = 0; i < header.entryCount && valid; ++i) {
+            LogFile::EntryHeader entryHeader;
+            valid = offset + sizeof(entryHeader) <= block.size();
+            if (valid) {
+                memcpy(&entryHeader, block.data() + offset, sizeof(entryHeader));
+                offset += sizeof(entryHeader) + entryHeader.tagLength + entryHeader.messageLength;
+                valid = offset <= block.size();
+            }
+        }
+        if (!valid) {
+            ++corruptBlocks;
+            continue;
+        }
+
+        blockOffset = 0;
+        blockRemaining = header.entryCount;
+        return true;
+    }
+}
@@ -0,0 +1,202 @@
+/**
+ * @file ESPLogFile.h
+ * @brief Persistent log storage on a filesystem with size-based rotation.
+ *
+ * ESPLogFileSink receives entries from the Logger and appends them to
+ * <directory>/log0.bin in blocks of several entries, so flash is written
+ * in a few large chunks instead of once per line. When log0.bin reaches
+ * maxFileSize the files are shifted (log0 -> log1 -> ...) and the oldest
+ * is deleted. ESPLogFileReader replays the files, oldest first, as
+ * Logger::LogEntry values.
+ *
+ * Files are accessed through stdio, so on the ESP32 the directory must be
+ * on a mounted VFS (e.g. "/littlefs/logs" after LittleFS.begin()) and on a
+ * host any plain directory works.
+ *
+ * File format: a sequence of blocks, each a BlockHeader followed by
+ * payloadLength bytes of entries. Every entry is an EntryHeader followed by
+ * the tag and message bytes without terminators. The CRC covers the
+ * payload, so a block torn by a reset is detected and skipped.
+ */
+
+#ifndef ESP_LOG_FILE_H
+#define ESP_LOG_FILE_H
+
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "ESPLogger.h"
+
+namespace LogFile {
+
+static constexpr uint32_t BLOCK_MAGIC = 0x424C474C; ///< "LGLB" in little-endian byte order
+static constexpr uint16_t FORMAT_VERSION = 1;       ///< Version written in every block header
+static constexpr size_t MAX_BLOCK_SIZE = 64 * 1024; ///< Largest block the sink writes and the reader accepts
+
+/**
+ * @struct BlockHeader
+ * @brief Header in front of every block of entries.
+ */
+struct BlockHeader {
+    uint32_t magic;          ///< BLOCK_MAGIC
+    uint16_t version;        ///< FORMAT_VERSION
+    uint16_t entryCount;     ///< Number of entries in the block
+    uint32_t payloadLength;  ///< Number of bytes following the header
+    uint32_t crc;            ///< CRC-32 of the payload
+};
+
+/**
+ * @struct EntryHeader
+ * @brief Fixed part of one entry inside a block.
+ */
+struct EntryHeader {
+    int64_t timestamp;       ///< Microseconds since boot
+    uint8_t level;           ///< Severity level
+    uint8_t tagLength;       ///< Number of tag bytes
+    uint16_t messageLength;  ///< Number of message bytes
+};
+
+static_assert(sizeof(BlockHeader) == 16, "Block header layout is part of the file format");
+static_assert(sizeof(EntryHeader) == 16, "Entry header layout is part of the file format");
+
+/**
+ * @brief Build the path of a log file.
+ * @param path Destination buffer.
+ * @param size Size of the destination buffer.
+ * @param directory Log directory.
+ * @param index File index, 0 being the newest.
+ */
+void filePath(char* path, size_t size, const char* directory, size_t index);
+
+} // namespace LogFile
+
+/**
+ * @class ESPLogFileSink
+ * @brief Logger sink appending entries to rotating files in batched blocks.
+ */
+class ESPLogFileSink : public Logger::Sink {
+public:
+    /**
+     * @struct Config
+     * @brief Configuration of the file sink.
+     */
+    struct Config {
+        const char* directory = "/littlefs/logs"; /**< Directory holding the log files */
+        size_t fileCount = 4;          /**< Number of files kept, including the current one */
+        size_t maxFileSize = 64 * 1024; /**< Size in bytes at which the current file is rotated */
+        size_t blockSize = 4096;       /**< Bytes buffered in RAM before a block is written, at most MAX_BLOCK_SIZE */
+        uint32_t flushInterval = 30000; /**< Maximum time in ms an entry stays buffered; checked on every write
+                                             and, with the dispatcher running, while logging is quiet */
+    };
+
+    /**
+     * @brief Constructor for the file sink.
+     * @param config The configuration of the sink.
+     */
+    explicit ESPLogFileSink(const Config& config);
+
+    /**
+     * @brief Destructor, writes any buffered entries.
+     */
+    ~ESPLogFileSink() override;
+
+    /**
+     * @brief Create the directory and open the current file.
+     *
+     * Register the sink with Logger::addSink after this succeeds.
+     * @return true if the current file could be opened.
+     */
+    bool begin();
+
+    /**
+     * @brief Buffer entries and write a block when it is full or flushInterval has passed.
+     * @param entries Pointer to the first entry.
+     * @param count Number of entries.
+     */
+    void write(const Logger::LogEntry* entries, size_t count) override;
+
+    /**
+     * @brief Write the buffered entries if flushInterval has passed since the oldest one.
+     */
+    void idle() override;
+
+    /**
+     * @brief Write buffered entries now, e.g. before a restart or deep sleep.
+     * @return true if nothing was pending or the block was written.
+     */
+    bool flush();
+
+    /**
+     * @brief Get the number of blocks that could not be written.
+     * @return Number of failed block writes.
+     */
+    size_t getWriteErrorCount() const;
+
+private:
+    bool writeBlock();
+    void flushIfDue();
+    bool rotate();
+    bool openCurrent();
+
+    Config config;
+    std::mutex mutex;
+    FILE* file;
+    size_t fileSize;
+    std::vector<uint8_t> block;
+    uint16_t blockEntries;
+    int64_t blockStarted;
+    size_t writeErrors;
+};
+
+/**
+ * @class ESPLogFileReader
+ * @brief Replays entries stored by ESPLogFileSink, oldest file first.
+ */
+class ESPLogFileReader {
+public:
+    /**
+     * @brief Constructor for the file reader.
+     * @param directory Directory holding the log files.
+     * @param fileCount Number of files the sink keeps.
+     */
+    ESPLogFileReader(const char* directory, size_t fileCount);
+
+    /**
+     * @brief Destructor, closes the open file.
+     */
+    ~ESPLogFileReader();
+
+    /**
+     * @brief Read the next stored entry.
+     * @param entry Reference to a LogEntry structure to be filled.
+     * @return true if an entry was read, false once all files are exhausted.
+     */
+    bool next(Logger::LogEntry& entry);
+
+    /**
+     * @brief Start over from the oldest file.
+     */
+    void rewind();
+
+    /**
+     * @brief Get the number of damaged blocks skipped so far.
+     * @return Number of blocks with a bad header or CRC.
+     */
+    size_t getCorruptBlockCount() const;
+
+private:
+    bool openNextFile();
+    bool readBlock();
+
+    const char* directory;
+    size_t fileCount;
+    size_t nextFile;
+    FILE* file;
+    std::vector<uint8_t> block;
+    size_t blockOffset;
+    size_t blockRemaining;
+    size_t corruptBlocks;
+};
+
+#endif // ESP_LOG_FILE_H
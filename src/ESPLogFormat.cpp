@@ -0,0 +1,374 @@
+#include "ESPLogFormat.h"
+#include <cstdio>
+#include <cstdint>
+#include <cctype>
+#include <algorithm>
+
+namespace LogFormat {
+
+namespace {
+
+enum class LengthModifier { NONE, HH, H, L, LL, J, Z, T, LONG_DOUBLE };
+
+struct Value {
+    ArgType type;
+    uint64_t bits;
+    double real;
+    const char* text;
+};
+
+class ArgReader {
+public:
+    ArgReader(const uint8_t* data, size_t length) : data(data), length(length), offset(0) {}
+
+    bool next(Value& value) {
+        if (offset >= length) {
+            return false;
+        }
+        value.type = static_cast<ArgType>(data[offset++]);
+        switch (value.type) {
+            case ArgType::INT32: {
+                int32_t v;
+                if (!read(v)) return false;
+                value.bits = static_cast<uint64_t>(static_cast<int64_t>(v));
+                return true;
+            }
+            case ArgType::UINT32: {
+                uint32_t v;
+                if (!read(v)) return false;
+                value.bits = v;
+                return true;
+            }
+            case ArgType::INT64:
+            case ArgType::UINT64:
+            case ArgType::POINTER:
+                return read(value.bits);
+            case ArgType::DOUBLE:
+                return read(value.real);
+            case ArgType::STRING: {
+                if (offset >= length) return false;
+                size_t textLength = data[offset++];
+                if (offset + textLength + 1 > length) return false;
+                value.text = reinterpret_cast<const char*>(data + offset);
+                offset += textLength + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t consumed() const { return offset; }
+
+private:
+    template<typename T>
+    bool read(T& value) {
+        if (offset + sizeof(T) > length) {
+            return false;
+        }
+        memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+};
+
+class Output {
+public:
+    Output(char* out, size_t size) : out(out), size(size), position(0) { out[0] = '\0'; }
+
+    void put(char c) {
+        if (position + 1 < size) {
+            out[position++] = c;
+            out[position] = '\0';
+        }
+    }
+
+    void append(const char* text, size_t textLength) {
+        for (size_t i = 0; i < textLength; ++i) {
+            put(text[i]);
+        }
+    }
+
+    template<typename T>
+    void emit(const char* spec, const int* stars, size_t starCount, T value) {
+        char* dst = out + position;
+        size_t room = size - position;
+        int written;
+        switch (starCount) {
+            case 2: written = snprintf(dst, room, spec, stars[0], stars[1], value); break;
+            case 1: written = snprintf(dst, room, spec, stars[0], value); break;
+            default: written = snprintf(dst, room, spec, value); break;
+        }
+        if (written > 0) {
+            position += std::min(static_cast<size_t>(written), room - 1);
+        }
+    }
+
+    size_t length() const { return position; }
+
+private:
+    char* out;
+    size_t size;
+    size_t position;
+};
+
+int64_t asSigned(const Value& value) {
+    return value.type == ArgType::DOUBLE ? static_cast<int64_t>(value.real) : static_cast<int64_t>(value.bits);
+}
+
+uint64_t asUnsigned(const Value& value) {
+    return value.type == ArgType::DOUBLE ? static_cast<uint64_t>(value.real) : value.bits;
+}
+
+double asDouble(const Value& value) {
+    switch (value.type) {
+        case ArgType::DOUBLE: return value.real;
+        case ArgType::INT32:
+        case ArgType::INT64: return static_cast<double>(static_cast<int64_t>(value.bits));
+        default: return static_cast<double>(value.bits);
+    }
+}
+
+void emitValue(Output& output, const char* spec, char conversion, LengthModifier modifier,
+               const int* stars, size_t starCount, const Value& value) {
+    if (value.type == ArgType::STRING && conversion != 's') {
+        output.append("(?)", 3);
+        return;
+    }
+
+    switch (conversion) {
+        case 'd':
+        case 'i': {
+            int64_t v = asSigned(value);
+            switch (modifier) {
+                case LengthModifier::L: output.emit(spec, stars, starCount, static_cast<long>(v)); break;
+                case LengthModifier::LL: output.emit(spec, stars, starCount, static_cast<long long>(v)); break;
+                case LengthModifier::J: output.emit(spec, stars, starCount, static_cast<intmax_t>(v)); break;
+                case LengthModifier::Z:
+                case LengthModifier::T: output.emit(spec, stars, starCount, static_cast<ptrdiff_t>(v)); break;
+                default: output.emit(spec, stars, starCount, static_cast<int>(v)); break;
+            }
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            uint64_t v = asUnsigned(value);
+            switch (modifier) {
+                case LengthModifier::L: output.emit(spec, stars, starCount, static_cast<unsigned long>(v)); break;
+                case LengthModifier::LL: output.emit(spec, stars, starCount, static_cast<unsigned long long>(v)); break;
+                case LengthModifier::J: output.emit(spec, stars, starCount, static_cast<uintmax_t>(v)); break;
+                case LengthModifier::Z:
+                case LengthModifier::T: output.emit(spec, stars, starCount, static_cast<size_t>(v)); break;
+                default: output.emit(spec, stars, starCount, static_cast<unsigned>(v)); break;
+            }
+            break;
+        }
+        case 'c':
+            output.emit(spec, stars, starCount, static_cast<int>(asSigned(value)));
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (modifier == LengthModifier::LONG_DOUBLE) {
+                output.emit(spec, stars, starCount, static_cast<long double>(asDouble(value)));
+            } else {
+                output.emit(spec, stars, starCount, asDouble(value));
+            }
+            break;
+        case 's':
+            if (value.type == ArgType::STRING) {
+                output.emit(spec, stars, starCount, value.text);
+            } else {
+                output.append("(?)", 3);
+            }
+            break;
+        case 'p':
+            output.emit(spec, stars, starCount, reinterpret_cast<void*>(static_cast<uintptr_t>(value.bits)));
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace
+
+void ArgPacker::addString(const char* value) {
+    if (value == nullptr) {
+        value = "(null)";
+    }
+    if (length + 3 > capacity) {
+        cut = true;
+        return;
+    }
+
+    size_t textLength = strlen(value);
+    size_t space = capacity - length - 3;
+    size_t room = std::min<size_t>(space - std::min(space, reserved), UINT8_MAX);
+    if (textLength > room) {
+        textLength = room;
+        cut = true;
+    }
+
+    buffer[length++] = static_cast<uint8_t>(ArgType::STRING);
+    buffer[length++] = static_cast<uint8_t>(textLength);
+    memcpy(buffer + length, value, textLength);
+    length += textLength;
+    buffer[length++] = '\0';
+}
+
+bool FieldReader::next(FieldValue& field) {
+    ArgReader reader(data + offset, length - offset);
+    Value key = {};
+    Value value = {};
+    if (!reader.next(key) || key.type != ArgType::STRING || !reader.next(value)) {
+        offset = length;
+        return false;
+    }
+    offset += reader.consumed();
+
+    field.key = key.text;
+    field.type = value.type;
+    field.bits = value.bits;
+    field.real = value.real;
+    field.text = value.text;
+    return true;
+}
+
+size_t formatFields(char* out, size_t size, const uint8_t* fields, size_t fieldsLength) {
+    if (size == 0) {
+        return 0;
+    }
+
+    Output output(out, size);
+    FieldReader reader(fields, fieldsLength);
+    FieldValue field;
+    while (reader.next(field)) {
+        output.put(' ');
+        output.append(field.key, strlen(field.key));
+        output.put('=');
+        switch (field.type) {
+            case ArgType::INT32:
+            case ArgType::INT64:
+                output.emit("%lld", nullptr, 0, static_cast<long long>(field.bits));
+                break;
+            case ArgType::UINT32:
+            case ArgType::UINT64:
+                output.emit("%llu", nullptr, 0, static_cast<unsigned long long>(field.bits));
+                break;
+            case ArgType::DOUBLE:
+                output.emit("%g", nullptr, 0, field.real);
+                break;
+            case ArgType::POINTER:
+                output.emit("%p", nullptr, 0, reinterpret_cast<void*>(static_cast<uintptr_t>(field.bits)));
+                break;
+            case ArgType::STRING:
+                output.append(field.text, strlen(field.text));
+                break;
+        }
+    }
+    return output.length();
+}
+
+size_t formatPacked(char* out, size_t size, const char* format, const uint8_t* args, size_t argsLength) {
+    if (size == 0) {
+        return 0;
+    }
+
+    Output output(out, size);
+    ArgReader reader(args, argsLength);
+    Value value = {};
+
+    if (format == nullptr) {
+        if (reader.next(value) && value.type == ArgType::STRING) {
+            output.append(value.text, strlen(value.text));
+        }
+        return output.length();
+    }
+
+    const char* p = format;
+    while (*p != '\0') {
+        if (*p != '%') {
+            output.put(*p++);
+            continue;
+        }
+        if (p[1] == '%') {
+            output.put('%');
+            p += 2;
+            continue;
+        }
+
+        const char* specStart = p++;
+        int stars[2];
+        size_t starCount = 0;
+        bool missingArg = false;
+
+        while (*p != '\0' && strchr("-+ #0", *p) != nullptr) {
+            ++p;
+        }
+        if (*p == '*') {
+            ++p;
+            missingArg |= !reader.next(value);
+            stars[starCount++] = static_cast<int>(asSigned(value));
+        } else {
+            while (isdigit(static_cast<unsigned char>(*p))) ++p;
+        }
+        if (*p == '.') {
+            ++p;
+            if (*p == '*') {
+                ++p;
+                missingArg |= !reader.next(value);
+                stars[starCount++] = static_cast<int>(asSigned(value));
+            } else {
+                while (isdigit(static_cast<unsigned char>(*p))) ++p;
+            }
+        }
+
+        LengthModifier modifier = LengthModifier::NONE;
+        switch (*p) {
+            case 'h': modifier = (p[1] == 'h') ? LengthModifier::HH : LengthModifier::H; break;
+            case 'l': modifier = (p[1] == 'l') ? LengthModifier::LL : LengthModifier::L; break;
+            case 'j': modifier = LengthModifier::J; break;
+            case 'z': modifier = LengthModifier::Z; break;
+            case 't': modifier = LengthModifier::T; break;
+            case 'L': modifier = LengthModifier::LONG_DOUBLE; break;
+            default: break;
+        }
+        if (modifier == LengthModifier::HH || modifier == LengthModifier::LL) {
+            p += 2;
+        } else if (modifier != LengthModifier::NONE) {
+            ++p;
+        }
+
+        char conversion = *p;
+        if (conversion == '\0') {
+            output.append(specStart, p - specStart);
+            break;
+        }
+        ++p;
+
+        char spec[16];
+        size_t specLength = p - specStart;
+        if (specLength >= sizeof(spec) || missingArg || conversion == 'n' || !reader.next(value)) {
+            output.append(specStart, specLength);
+            continue;
+        }
+        memcpy(spec, specStart, specLength);
+        spec[specLength] = '\0';
+
+        emitValue(output, spec, conversion, modifier, stars, starCount, value);
+    }
+
+    return output.length();
+}
+
+} // namespace LogFormat
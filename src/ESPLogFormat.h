@@ -0,0 +1,270 @@
+/**
+ * @file ESPLogFormat.h
+ * @brief Packing of printf arguments into raw bytes and deferred formatting.
+ *
+ * Arguments are stored as a type code followed by their value so a log entry
+ * can keep the format string pointer and the packed bytes, and only run the
+ * formatter when the entry is read. Strings are copied, since the pointer
+ * passed to the log call is rarely valid by then.
+ *
+ * Structured fields use the same encoding: each field is its key packed as a
+ * string followed by its packed value.
+ *
+ * This header has no Arduino dependencies so host tools can decode packed
+ * arguments with the same code.
+ */
+
+#ifndef ESP_LOG_FORMAT_H
+#define ESP_LOG_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace LogFormat {
+
+/**
+ * @enum ArgType
+ * @brief Type codes stored in front of each packed argument.
+ */
+enum class ArgType : uint8_t {
+    INT32 = 'i',   /**< Signed integer up to 32 bits */
+    UINT32 = 'u',  /**< Unsigned integer up to 32 bits */
+    INT64 = 'I',   /**< Signed 64-bit integer */
+    UINT64 = 'U',  /**< Unsigned 64-bit integer */
+    DOUBLE = 'd',  /**< Floating point value, promoted to double */
+    POINTER = 'p', /**< Pointer value */
+    STRING = 's'   /**< Length-prefixed copy of a C string */
+};
+
+/**
+ * @class ArgPacker
+ * @brief Appends typed arguments to a fixed-size byte buffer.
+ */
+class ArgPacker {
+public:
+    ArgPacker(uint8_t* buffer, size_t capacity)
+        : buffer(buffer), capacity(capacity), length(0), reserved(0), cut(false) {}
+
+    /**
+     * @brief Get the fewest bytes an argument of a type can be packed in.
+     * @return Size of the packed value, or of an empty string for strings.
+     */
+    template<typename T>
+    static constexpr size_t minimumSize() {
+        using Type = std::decay_t<T>;
+        if constexpr (std::is_same_v<Type, char*> || std::is_same_v<Type, const char*>) {
+            return 3; // Type code, length and terminator
+        } else if constexpr (std::is_floating_point_v<Type> || std::is_pointer_v<Type> ||
+                             std::is_null_pointer_v<Type> || sizeof(Type) > 4) {
+            return 1 + 8;
+        } else {
+            return 1 + 4;
+        }
+    }
+
+    /**
+     * @brief Append all arguments of a log call.
+     *
+     * Room for the arguments after a string is set aside before the string
+     * is copied, so a long string is shortened instead of crowding out the
+     * arguments that follow it.
+     * @param args Arguments to pack.
+     */
+    template<typename... Args>
+    void addAll(const Args&... args) {
+        reserved = (minimumSize<Args>() + ... + 0);
+        (addNext(args), ...);
+    }
+
+    template<typename T>
+    void add(const T& value) {
+        using Type = std::decay_t<T>;
+        if constexpr (std::is_same_v<Type, char*> || std::is_same_v<Type, const char*>) {
+            addString(value);
+        } else if constexpr (std::is_enum_v<Type>) {
+            add(static_cast<std::underlying_type_t<Type>>(value));
+        } else if constexpr (std::is_floating_point_v<Type>) {
+            addValue(ArgType::DOUBLE, static_cast<double>(value));
+        } else if constexpr (std::is_integral_v<Type> && sizeof(Type) <= 4) {
+            if constexpr (std::is_signed_v<Type>) {
+                addValue(ArgType::INT32, static_cast<int32_t>(value));
+            } else {
+                addValue(ArgType::UINT32, static_cast<uint32_t>(value));
+            }
+        } else if constexpr (std::is_integral_v<Type>) {
+            if constexpr (std::is_signed_v<Type>) {
+                addValue(ArgType::INT64, static_cast<int64_t>(value));
+            } else {
+                addValue(ArgType::UINT64, static_cast<uint64_t>(value));
+            }
+        } else if constexpr (std::is_pointer_v<Type> || std::is_null_pointer_v<Type>) {
+            addValue(ArgType::POINTER, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+        } else {
+            static_assert(std::is_pointer_v<Type>, "Unsupported log argument type");
+        }
+    }
+
+    /**
+     * @brief Copy a C string, truncated to the space not reserved for later arguments.
+     * @param value String to copy; nullptr is stored as "(null)".
+     */
+    void addString(const char* value);
+
+    /**
+     * @brief Append a key and its value, or nothing if the value does not fit.
+     * @param key Field name.
+     * @param value Field value.
+     */
+    template<typename T>
+    void addField(const char* key, const T& value) {
+        size_t mark = length;
+        addString(key);
+        size_t valueStart = length;
+        add(value);
+        if (valueStart == mark || length == valueStart) {
+            length = mark;
+        }
+    }
+
+    /**
+     * @brief Get the number of bytes written so far.
+     * @return Packed length in bytes.
+     */
+    size_t size() const { return length; }
+
+    /**
+     * @brief Check whether a string was shortened or a value left out.
+     * @return true if the packed bytes do not hold every argument in full.
+     */
+    bool truncated() const { return cut; }
+
+private:
+    template<typename T>
+    void addNext(const T& value) {
+        reserved -= minimumSize<T>();
+        add(value);
+    }
+
+    template<typename T>
+    void addValue(ArgType type, T value) {
+        if (length + 1 + sizeof(T) > capacity) {
+            cut = true;
+            return;
+        }
+        buffer[length++] = static_cast<uint8_t>(type);
+        memcpy(buffer + length, &value, sizeof(T));
+        length += sizeof(T);
+    }
+
+    uint8_t* buffer;
+    size_t capacity;
+    size_t length;
+    size_t reserved; ///< Minimum size of the arguments addAll has not packed yet
+    bool cut;        ///< Set when an argument did not fit in full
+};
+
+/**
+ * @brief Pack printf arguments into a buffer.
+ * @param buffer Destination buffer.
+ * @param capacity Size of the destination buffer.
+ * @param args Arguments to pack.
+ * @return Number of bytes used. Strings are shortened to leave room for the
+ * arguments after them; values that still do not fit are left out.
+ */
+template<typename... Args>
+size_t packArgs(uint8_t* buffer, size_t capacity, const Args&... args) {
+    ArgPacker packer(buffer, capacity);
+    packer.addAll(args...);
+    return packer.size();
+}
+
+/**
+ * @struct Field
+ * @brief Typed key/value pair of a structured log entry.
+ *
+ * Only valid for the duration of the log call it is passed to.
+ */
+template<typename T>
+struct Field {
+    const char* key; ///< Field name
+    const T& value;  ///< Field value, packed like a printf argument
+};
+
+/**
+ * @brief Pack structured fields into a buffer.
+ * @param buffer Destination buffer.
+ * @param capacity Size of the destination buffer.
+ * @param fields Fields to pack.
+ * @return Number of bytes used. Fields that do not fit are left out.
+ */
+template<typename... Values>
+size_t packFields(uint8_t* buffer, size_t capacity, const Field<Values>&... fields) {
+    ArgPacker packer(buffer, capacity);
+    (packer.addField(fields.key, fields.value), ...);
+    return packer.size();
+}
+
+/**
+ * @struct FieldValue
+ * @brief Field decoded by FieldReader; points into the packed bytes.
+ */
+struct FieldValue {
+    const char* key;   ///< Field name
+    ArgType type;      ///< Type of the value
+    uint64_t bits;     ///< Integer and pointer values, sign-extended for INT32
+    double real;       ///< Value of DOUBLE fields
+    const char* text;  ///< Value of STRING fields
+};
+
+/**
+ * @class FieldReader
+ * @brief Iterates over fields packed by packFields.
+ */
+class FieldReader {
+public:
+    FieldReader(const uint8_t* data, size_t length) : data(data), length(length), offset(0) {}
+
+    /**
+     * @brief Decode the next field.
+     * @param field Filled when a field is returned.
+     * @return true if a field was decoded, false at the end or on malformed bytes.
+     */
+    bool next(FieldValue& field);
+
+private:
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+};
+
+/**
+ * @brief Format packed fields as " key=value" pairs.
+ * @param out Destination buffer, always null-terminated when size > 0.
+ * @param size Size of the destination buffer.
+ * @param fields Fields packed by packFields.
+ * @param fieldsLength Number of packed bytes.
+ * @return Number of characters written, excluding the terminator.
+ */
+size_t formatFields(char* out, size_t size, const uint8_t* fields, size_t fieldsLength);
+
+/**
+ * @brief Format packed arguments using a printf format string.
+ *
+ * Each conversion takes the next packed argument and casts it to the type the
+ * conversion expects, so the result does not depend on the platform the
+ * arguments were packed on. Conversions without a matching argument are
+ * copied literally.
+ * @param out Destination buffer, always null-terminated when size > 0.
+ * @param size Size of the destination buffer.
+ * @param format printf format string; nullptr formats the first argument as a string.
+ * @param args Packed arguments.
+ * @param argsLength Number of packed bytes.
+ * @return Number of characters written, excluding the terminator.
+ */
+size_t formatPacked(char* out, size_t size, const char* format, const uint8_t* args, size_t argsLength);
+
+} // namespace LogFormat
+
+#endif // ESP_LOG_FORMAT_H
@@ -0,0 +1,278 @@
+#include "ESPLogWire.h"
+#include "ESPLogFormat.h"
+#include <cstring>
+
+namespace LogWire {
+
+namespace {
+
+static constexpr size_t TEXT_FALLBACK_SIZE = 256; ///< Message size when a format has no id left
+static constexpr size_t DECODED_MESSAGE_SIZE = 1024; ///< Longest message the decoder formats
+
+/**
+ * @class ByteWriter
+ * @brief Bounds-checked appender that remembers whether anything did not fit.
+ */
+class ByteWriter {
+public:
+    ByteWriter(uint8_t* out, size_t size) : out(out), size(size), length(0), overflow(false) {}
+
+    void byte(uint8_t value) {
+        if (length < size) {
+            out[length++] = value;
+        } else {
+            overflow = true;
+        }
+    }
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            byte(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        byte(static_cast<uint8_t>(value));
+    }
+
+    void bytes(const void* data, size_t count) {
+        varint(count);
+        if (length + count > size) {
+            overflow = true;
+            return;
+        }
+        memcpy(out + length, data, count);
+        length += count;
+    }
+
+    uint8_t* out;
+    size_t size;
+    size_t length;
+    bool overflow;
+};
+
+uint8_t recordByte(RecordType type, uint8_t level = 0) {
+    return static_cast<uint8_t>(static_cast<uint8_t>(type) << 4 | (level & 0x0F));
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+} // namespace
+
+Encoder::Encoder() {
+    reset();
+}
+
+void Encoder::reset() {
+    headerWritten = false;
+    nextSequence = 0;
+    lastTimestamp = 0;
+    memset(definedTags, 0, sizeof(definedTags));
+    formatCount = 0;
+}
+
+size_t Encoder::encode(const Entry& entry, uint8_t* out, size_t size) {
+    ByteWriter writer(out, size);
+
+    if (!headerWritten) {
+        writer.byte(recordByte(RecordType::HEADER));
+        for (uint8_t magic : MAGIC) {
+            writer.byte(magic);
+        }
+        writer.byte(VERSION);
+    }
+
+    bool newTag = (definedTags[entry.tag / 32] & (1u << (entry.tag % 32))) == 0;
+    if (newTag) {
+        writer.byte(recordByte(RecordType::TAG));
+        writer.varint(entry.tag);
+        writer.bytes(entry.tagName, strlen(entry.tagName));
+    }
+
+    // Resolve the format id, defining a new one if there is room
+    const char* message = entry.message;
+    size_t messageLength = entry.messageLength;
+    char fallback[TEXT_FALLBACK_SIZE];
+    uint32_t formatId = NO_FORMAT_ID;
+    bool newFormat = false;
+    if (message == nullptr && entry.format != nullptr) {
+        for (size_t i = 0; i < formatCount && formatId == NO_FORMAT_ID; ++i) {
+            if (formats[i] == entry.format) {
+                formatId = static_cast<uint32_t>(i + 1);
+            }
+        }
+        if (formatId == NO_FORMAT_ID && formatCount < MAX_FORMATS) {
+            formatId = static_cast<uint32_t>(formatCount + 1);
+            newFormat = true;
+            writer.byte(recordByte(RecordType::FORMAT));
+            writer.varint(formatId);
+            writer.bytes(entry.format, strlen(entry.format));
+        } else if (formatId == NO_FORMAT_ID) {
+            messageLength = LogFormat::formatPacked(fallback, sizeof(fallback), entry.format, entry.args, entry.argsLength);
+            message = fallback;
+        }
+    }
+
+    writer.byte(recordByte(message != nullptr ? RecordType::TEXT : RecordType::FORMATTED, entry.level));
+    writer.varint(entry.sequence - nextSequence);
+    writer.varint(zigzag(entry.timestamp - lastTimestamp));
+    writer.varint(entry.tag);
+    if (message != nullptr) {
+        writer.bytes(message, messageLength);
+    } else {
+        writer.varint(formatId);
+        writer.bytes(entry.args, entry.argsLength);
+    }
+
+    if (writer.overflow) {
+        return 0;
+    }
+
+    headerWritten = true;
+    nextSequence = entry.sequence + 1;
+    lastTimestamp = entry.timestamp;
+    if (newTag) {
+        definedTags[entry.tag / 32] |= 1u << (entry.tag % 32);
+    }
+    if (newFormat) {
+        formats[formatCount++] = entry.format;
+    }
+    return writer.length;
+}
+
+Decoder::Decoder(const uint8_t* data, size_t length) : data(data), length(length), position(0) {
+    resetState();
+}
+
+void Decoder::resetState() {
+    nextSequence = 0;
+    lastTimestamp = 0;
+    for (std::string& tag : tags) {
+        tag.clear();
+    }
+    formats.clear();
+}
+
+size_t Decoder::offset() const {
+    return position;
+}
+
+bool Decoder::readVarint(uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (position >= length) {
+            return false;
+        }
+        uint8_t byte = data[position++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Decoder::readBytes(std::string& value) {
+    uint64_t count;
+    if (!readVarint(count) || count > length - position) {
+        return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data + position), count);
+    position += count;
+    return true;
+}
+
+Decoder::Status Decoder::next(DecodedEntry& entry) {
+    while (position < length) {
+        const size_t recordStart = position;
+        const uint8_t first = data[position++];
+        const RecordType type = static_cast<RecordType>(first >> 4);
+        const uint8_t level = first & 0x0F;
+        uint64_t id;
+        std::string bytes;
+        bool valid;
+
+        switch (type) {
+            case RecordType::HEADER:
+                valid = length - position >= sizeof(MAGIC) + 1 &&
+                        memcmp(data + position, MAGIC, sizeof(MAGIC)) == 0 &&
+                        data[position + sizeof(MAGIC)] == VERSION;
+                if (valid) {
+                    position += sizeof(MAGIC) + 1;
+                    resetState();
+                }
+                break;
+
+            case RecordType::TAG:
+                valid = readVarint(id) && id < MAX_TAGS && readBytes(bytes);
+                if (valid) {
+                    tags[id] = bytes;
+                }
+                break;
+
+            case RecordType::FORMAT:
+                valid = readVarint(id) && id != NO_FORMAT_ID && id <= Encoder::MAX_FORMATS && readBytes(bytes);
+                if (valid) {
+                    if (formats.size() < id) {
+                        formats.resize(id);
+                    }
+                    formats[id - 1] = bytes;
+                }
+                break;
+
+            case RecordType::TEXT:
+            case RecordType::FORMATTED: {
+                uint64_t gap;
+                uint64_t delta;
+                uint64_t tag;
+                valid = readVarint(gap) && readVarint(delta) && readVarint(tag) && tag < MAX_TAGS;
+                uint64_t formatId = NO_FORMAT_ID;
+                if (valid && type == RecordType::FORMATTED) {
+                    valid = readVarint(formatId);
+                }
+                valid = valid && readBytes(bytes);
+                if (!valid) {
+                    break;
+                }
+
+                entry.sequence = nextSequence + static_cast<uint32_t>(gap);
+                entry.lost = static_cast<uint32_t>(gap);
+                entry.timestamp = lastTimestamp + unzigzag(delta);
+                entry.level = level;
+                entry.tag = static_cast<uint8_t>(tag);
+                entry.tagName = tags[tag].empty() ? "?" : tags[tag].c_str();
+                nextSequence = entry.sequence + 1;
+                lastTimestamp = entry.timestamp;
+
+                if (type == RecordType::TEXT) {
+                    entry.message = bytes;
+                } else if (formatId != NO_FORMAT_ID && (formatId > formats.size() || formats[formatId - 1].empty())) {
+                    entry.message = "<unknown format " + std::to_string(formatId) + ">";
+                } else {
+                    const char* format = formatId == NO_FORMAT_ID ? nullptr : formats[formatId - 1].c_str();
+                    const uint8_t* args = reinterpret_cast<const uint8_t*>(bytes.data());
+                    char text[DECODED_MESSAGE_SIZE];
+                    size_t textLength = LogFormat::formatPacked(text, sizeof(text), format, args, bytes.size());
+                    entry.message.assign(text, textLength);
+                }
+                return Status::ENTRY;
+            }
+
+            default:
+                valid = false;
+                break;
+        }
+
+        if (!valid) {
+            position = recordStart;
+            return Status::ERROR;
+        }
+    }
+    return Status::END;
+}
+
+} // namespace LogWire
@@ -0,0 +1,172 @@
+/**
+ * @file ESPLogWire.h
+ * @brief Compact binary encoding of log entries for streaming and dumps.
+ *
+ * A stream is a sequence of records, each starting with a byte holding the
+ * record type in the high nibble and the level in the low nibble:
+ *
+ *   HEADER     0x00 'E' 'L' 'W' version
+ *   TAG        varint tagId, varint length, name bytes
+ *   FORMAT     varint formatId, varint length, format bytes
+ *   TEXT       entry fields, varint length, message bytes
+ *   FORMATTED  entry fields, varint formatId, varint length, packed args
+ *
+ * Entry fields are: varint sequence gap (sequence minus the one expected
+ * after the previous entry, so 0 unless entries were lost), zigzag varint
+ * timestamp delta in microseconds, varint tagId. Tag names and format
+ * strings are sent once per stream, before the first entry that uses them;
+ * format id 0 means "no format string, the first packed argument is the
+ * message". Args are packed with LogFormat, so the decoder formats them
+ * with the same code as the device.
+ *
+ * A HEADER resets the decoder, so streams split into chunks (e.g. one MQTT
+ * message each) stay decodable if the encoder is reset for every chunk.
+ *
+ * This header has no Arduino dependencies so host tools can decode dumps
+ * with the same code.
+ */
+
+#ifndef ESP_LOG_WIRE_H
+#define ESP_LOG_WIRE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace LogWire {
+
+static constexpr uint8_t VERSION = 1;               ///< Version written in every stream header
+static constexpr uint8_t MAGIC[3] = {'E', 'L', 'W'}; ///< Bytes following the header type
+static constexpr size_t MAX_TAGS = 256;             ///< Number of distinct tag ids
+static constexpr uint32_t NO_FORMAT_ID = 0;         ///< Format id of entries whose first argument is the message
+
+/**
+ * @enum RecordType
+ * @brief Record types stored in the high nibble of the first byte.
+ */
+enum class RecordType : uint8_t {
+    HEADER = 0,    /**< Start of a stream, resets the decoder */
+    TAG = 1,       /**< Tag name definition */
+    FORMAT = 2,    /**< Format string definition */
+    TEXT = 3,      /**< Entry with a formatted message */
+    FORMATTED = 4  /**< Entry with a format id and packed arguments */
+};
+
+/**
+ * @struct Entry
+ * @brief Entry handed to the encoder; either message or args is used.
+ */
+struct Entry {
+    uint32_t sequence;        ///< Sequence number given by the logger
+    int64_t timestamp;        ///< Microseconds since boot
+    uint8_t level;            ///< Severity level
+    uint8_t tag;              ///< Tag id
+    const char* tagName;      ///< Tag name, sent the first time the id is used
+    const char* message;      ///< Message bytes, or nullptr when args are used
+    size_t messageLength;     ///< Number of message bytes
+    const char* format;       ///< Format string of args, nullptr if the first argument is the message
+    const uint8_t* args;      ///< Arguments packed by LogFormat::packArgs
+    size_t argsLength;        ///< Number of packed bytes
+};
+
+/**
+ * @class Encoder
+ * @brief Stateful encoder; remembers which tags and formats the stream already defines.
+ */
+class Encoder {
+public:
+    static constexpr size_t MAX_FORMATS = 64; ///< Format strings given an id per stream
+
+    Encoder();
+
+    /**
+     * @brief Start a new stream; the next entry is preceded by a HEADER.
+     */
+    void reset();
+
+    /**
+     * @brief Encode an entry together with any definitions it needs.
+     *
+     * Format strings beyond MAX_FORMATS are formatted on the spot and sent
+     * as TEXT. Nothing is written, and the state is unchanged, if the entry
+     * does not fit.
+     * @param entry Entry to encode.
+     * @param out Destination buffer.
+     * @param size Size of the destination buffer.
+     * @return Number of bytes written, 0 if the entry does not fit.
+     */
+    size_t encode(const Entry& entry, uint8_t* out, size_t size);
+
+private:
+    bool headerWritten;
+    uint32_t nextSequence;
+    int64_t lastTimestamp;
+    uint32_t definedTags[MAX_TAGS / 32];
+    const char* formats[MAX_FORMATS];
+    size_t formatCount;
+};
+
+/**
+ * @struct DecodedEntry
+ * @brief Entry reconstructed by the decoder.
+ */
+struct DecodedEntry {
+    uint32_t sequence;     ///< Sequence number
+    uint32_t lost;         ///< Entries missing between the previous entry and this one
+    int64_t timestamp;     ///< Microseconds since boot
+    uint8_t level;         ///< Severity level
+    uint8_t tag;           ///< Tag id
+    const char* tagName;   ///< Tag name, "?" if its definition was not in the stream
+    std::string message;   ///< Formatted message
+};
+
+/**
+ * @class Decoder
+ * @brief Decodes a buffer holding one or more concatenated streams.
+ */
+class Decoder {
+public:
+    /**
+     * @enum Status
+     * @brief Outcome of Decoder::next.
+     */
+    enum class Status { ENTRY, END, ERROR };
+
+    /**
+     * @brief Constructor for the decoder.
+     * @param data Encoded bytes; must outlive the decoder.
+     * @param length Number of encoded bytes.
+     */
+    Decoder(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Decode up to the next entry, applying definitions on the way.
+     * @param entry Filled when ENTRY is returned.
+     * @return ENTRY, END at the end of the data, or ERROR on a truncated or unknown record.
+     */
+    Status next(DecodedEntry& entry);
+
+    /**
+     * @brief Get the offset of the next record.
+     * @return Offset in bytes; points at the bad record after ERROR.
+     */
+    size_t offset() const;
+
+private:
+    bool readVarint(uint64_t& value);
+    bool readBytes(std::string& value);
+    void resetState();
+
+    const uint8_t* data;
+    size_t length;
+    size_t position;
+    uint32_t nextSequence;
+    int64_t lastTimestamp;
+    std::string tags[MAX_TAGS];
+    std::vector<std::string> formats;
+};
+
+} // namespace LogWire
+
+#endif // ESP_LOG_WIRE_H
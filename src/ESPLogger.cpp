@@ -1,148 +1,210 @@
 #include "ESPLogger.h"
-#include <cstdarg>
-#include <cstring>
-#include <algorithm>
+#include <strings.h>
+
+void LoggerBase::setCallback(Observer cb) {
+    ObserverHandle previous;
+    {
+        std::lock_guard<std::mutex> lock(observerMutex);
+        previous = callbackHandle;
+        callbackHandle = INVALID_OBSERVER;
+    }
+    removeLogObserver(previous);
 
-Logger& Logger::instance() {
-    static Logger instance;
-    return instance;
+    ObserverHandle handle = cb ? addLogObserver(cb) : INVALID_OBSERVER;
+    std::lock_guard<std::mutex> lock(observerMutex);
+    callbackHandle = handle;
 }
 
-Logger::Logger() {}
-
-void Logger::setCallback(std::function<void(std::string_view, Level, std::string_view)> cb) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    callback = std::move(cb);
+LoggerBase::ObserverHandle LoggerBase::addLogObserver(Observer observer) {
+    std::lock_guard<std::mutex> lock(observerMutex);
+    for (size_t i = 0; i < MAX_OBSERVERS; ++i) {
+        ObserverSlot& slot = observerSlots[i];
+        if (!slot.active.load() && slot.users.load() == 0) {
+            slot.observer = observer;
+            slot.generation = (slot.generation + 1) & 0xFFFFFF;
+            slot.active.store(true);
+            sinksAttached.store(true);
+            // Generation in the upper bits so a stale handle cannot remove the slot's next observer
+            return (slot.generation << 8) | static_cast<ObserverHandle>(i + 1);
+        }
+    }
+    return INVALID_OBSERVER;
 }
 
-void Logger::addLogObserver(std::function<void(std::string_view, Level, std::string_view)> observer) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    observers.push_back(std::move(observer));
+bool LoggerBase::removeLogObserver(ObserverHandle handle) {
+    size_t index = (handle & 0xFF) - 1;
+    if (handle == INVALID_OBSERVER || index >= MAX_OBSERVERS) {
+        return false;
+    }
+
+    ObserverSlot& slot = observerSlots[index];
+    {
+        std::lock_guard<std::mutex> lock(observerMutex);
+        if (!slot.active.load() || slot.generation != (handle >> 8)) {
+            return false;
+        }
+        slot.active.store(false);
+    }
+
+    // Deliveries that saw the slot active may still be calling it
+    while (slot.users.load() != 0) {
+        vTaskDelay(1);
+    }
+    return true;
 }
 
-void Logger::setFilterLevel(Level level) {
-    filterLevel.store(level, std::memory_order_relaxed);
+void LoggerBase::setMirror(Mirror* target) {
+    mirror.store(target, std::memory_order_release);
 }
 
-bool Logger::getNextLog(LogEntry& entry) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    if (count.load(std::memory_order_relaxed) == 0) {
+bool LoggerBase::startDispatcher(const DispatcherConfig& config) {
+    if (dispatcherTask.load() != nullptr || config.batchSize == 0) {
         return false;
     }
 
-    size_t currentTail = tail.load(std::memory_order_relaxed);
-    memcpy(&entry, &buffer[currentTail], sizeof(LogEntry));
-    tail.store((currentTail + 1) % MAX_LOGS, std::memory_order_relaxed);
-    count.fetch_sub(1, std::memory_order_relaxed);
+    dispatcherConfig = config;
+    prepareDispatch(config.batchSize);
+    // Producers stop delivering inline from here, before the task exists and its handle is stored
+    dispatcherRunning.store(true);
+
+    TaskHandle_t handle = nullptr;
+    BaseType_t result = xTaskCreatePinnedToCore(dispatcherTaskWrapper, "LogDispatcher", config.stackSize,
+                                                this, config.priority, &handle, config.core);
+    if (result != pdPASS) {
+        dispatcherRunning.store(false);
+        return false;
+    }
+    dispatcherTask.store(handle);
     return true;
 }
 
-String Logger::getNextLogJson() {
-    LogEntry entry;
-    if (getNextLog(entry)) {
-        JsonDocument doc;
-        doc["tag"] = entry.tag;
-        doc["level"] = static_cast<int>(entry.level);
-        doc["message"] = entry.message;
+void LoggerBase::stopDispatcher() {
+    TaskHandle_t handle = dispatcherTask.load();
+    if (handle == nullptr || !dispatcherRunning.exchange(false)) {
+        return;
+    }
+
+    xTaskNotifyGive(handle);
 
-        String jsonString;
-        serializeJson(doc, jsonString);
-        return jsonString;
+    // The task clears the handle itself once the final drain is done
+    while (dispatcherTask.load() != nullptr) {
+        vTaskDelay(1);
     }
-    return String(""); // Empty string if no more logs
 }
 
-bool Logger::peekNextLog(LogEntry& entry, size_t offset) {
-    std::lock_guard<std::mutex> lock(logMutex);
-    if (count.load(std::memory_order_relaxed) == 0) {
-        return false;
-    }
+size_t LoggerBase::getSinkDroppedCount() const {
+    return sinkDropped.load(std::memory_order_relaxed);
+}
 
-    size_t index = (firstLogIndex + offset) % MAX_LOGS;
-    memcpy(&entry, &buffer[index], sizeof(LogEntry));
-    return true;
+size_t LoggerBase::getRepeatSuppressedCount() const {
+    return repeatSuppressed.load(std::memory_order_relaxed);
+}
+
+size_t LoggerBase::getRateLimitedCount() const {
+    return rateLimited.load(std::memory_order_relaxed);
+}
+
+size_t LoggerBase::getBusyDroppedCount() const {
+    return busyDropped.load(std::memory_order_relaxed);
+}
+
+void LoggerBase::setFilterLevel(Level level) {
+    filterLevel.store(level, std::memory_order_relaxed);
 }
 
-String Logger::peekNextLogJson(size_t offset) {
-    LogEntry entry;
-    if (peekNextLog(entry, offset)) {
-        JsonDocument doc;
-        doc["tag"] = entry.tag;
-        doc["level"] = static_cast<int>(entry.level);
-        doc["message"] = entry.message;
+const char* LoggerBase::levelToString(Level level) {
+    switch (level) {
+        case Level::DEBUG: return "DEBUG";
+        case Level::INFO: return "INFO";
+        case Level::WARNING: return "WARNING";
+        case Level::ERROR: return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
 
-        String jsonString;
-        serializeJson(doc, jsonString);
-        return jsonString;
+bool LoggerBase::parseLevel(std::string_view name, Level& level) {
+    for (Level candidate : {Level::DEBUG, Level::INFO, Level::WARNING, Level::ERROR}) {
+        const char* candidateName = levelToString(candidate);
+        if (name.length() == strlen(candidateName) && strncasecmp(name.data(), candidateName, name.length()) == 0) {
+            level = candidate;
+            return true;
+        }
     }
-    return String(""); // Empty string if no more logs
-}
-
-size_t Logger::getValidLogCount() const {
-    return std::min(count.load(std::memory_order_relaxed), MAX_LOGS);
-}
-
-size_t Logger::getLogCount() const {
-    return count.load(std::memory_order_relaxed);
-}
-
-void Logger::addLog(std::string_view tag, Level level, const char* message) {
-    if (level >= filterLevel.load(std::memory_order_relaxed)) {
-        std::lock_guard<std::mutex> lock(logMutex);
-        
-        size_t currentHead = head.load(std::memory_order_relaxed);
-        LogEntry& entry = buffer[currentHead];
-        
-        // Copy tag (with null termination)
-        strncpy(entry.tag, tag.data(), TAG_SIZE - 1);
-        entry.tag[TAG_SIZE - 1] = '\0';
-        entry.level = level;
-
-        // Copy message with potential overflow handling
-        size_t messageLen = strlen(message);
-        if (messageLen >= LOG_SIZE) {
-            // Message is too long, truncate and append overflow message
-            strncpy(entry.message, message, LOG_SIZE - OVERFLOW_MSG.length() - 1);
-            strcpy(entry.message + LOG_SIZE - OVERFLOW_MSG.length() - 1, OVERFLOW_MSG.data());
-        } else {
-            // Message fits, copy as is
-            strcpy(entry.message, message);
+    return false;
+}
+
+void LoggerBase::setEpochOffset(int64_t offset) {
+    epochOffset.store(offset, std::memory_order_relaxed);
+}
+
+int64_t LoggerBase::toEpochTime(int64_t timestamp) const {
+    int64_t offset = epochOffset.load(std::memory_order_relaxed);
+    return offset != 0 ? offset + timestamp : 0;
+}
+
+void LoggerBase::deliverText(const char* tag, Level level, const char* message) {
+    for (ObserverSlot& slot : observerSlots) {
+        if (!slot.active.load(std::memory_order_relaxed)) {
+            continue;
         }
-        entry.message[LOG_SIZE - 1] = '\0';
-
-        head.store((currentHead + 1) % MAX_LOGS, std::memory_order_relaxed);
-        size_t currentCount = count.load(std::memory_order_relaxed);
-        if (currentCount < MAX_LOGS) {
-            count.store(currentCount + 1, std::memory_order_relaxed);
-        } else {
-            // Buffer is full, move firstLogIndex
-            firstLogIndex.store((firstLogIndex.load(std::memory_order_relaxed) + 1) % MAX_LOGS, std::memory_order_relaxed);
+        slot.users.fetch_add(1);
+        if (slot.active.load()) {
+            slot.observer(tag, level, message);
         }
+        slot.users.fetch_sub(1);
+    }
 
-        if (callback) {
-            callback(entry.tag, entry.level, entry.message);
-        }
+    #ifdef ENABLE_SERIAL_PRINT
+    Serial.printf("[%s] %s: %s\n", tag, levelToString(level), message);
+    #endif
+}
 
-        for (const auto& observer : observers) {
-            observer(entry.tag, entry.level, entry.message);
-        }
+bool LoggerBase::hasInlineSinks() const {
+#ifdef ENABLE_SERIAL_PRINT
+    return true;
+#else
+    return sinksAttached.load(std::memory_order_relaxed);
+#endif
+}
 
-        #ifdef ENABLE_SERIAL_PRINT
-        const char* levelStr;
-        switch (level) {
-            case Level::DEBUG: levelStr = "DEBUG"; break;
-            case Level::INFO: levelStr = "INFO"; break;
-            case Level::WARNING: levelStr = "WARNING"; break;
-            case Level::ERROR: levelStr = "ERROR"; break;
-            default: levelStr = "UNKNOWN"; break;
-        }
-        Serial.printf("[%s] %s: %s\n", entry.tag, levelStr, entry.message);
-        #endif
+void LoggerBase::waitForDispatcher() {
+    const TickType_t start = xTaskGetTickCount();
+    const TickType_t timeout = pdMS_TO_TICKS(dispatcherConfig.blockTimeout);
+
+    while (dispatchBacklogFull() && xTaskGetTickCount() - start < timeout) {
+        vTaskDelay(1);
+    }
+}
+
+void LoggerBase::notifyDispatcher(TaskHandle_t dispatcher) {
+    if (dispatcherWaiting.exchange(false)) {
+        xTaskNotifyGive(dispatcher);
     }
 }
 
-void Logger::log(std::string_view tag, Level level, const char* message) {
-    if (level >= filterLevel.load(std::memory_order_relaxed)) {
-        addLog(tag, level, message);
+void LoggerBase::dispatcherTaskWrapper(void* pvParameters) {
+    LoggerBase* logger = static_cast<LoggerBase*>(pvParameters);
+    logger->dispatcherLoop();
+}
+
+void LoggerBase::dispatcherLoop() {
+    while (dispatcherRunning.load()) {
+        if (drainToSinks(false) > 0) {
+            continue;
+        }
+
+        // Announce that we are about to sleep, then retry once so an entry
+        // committed before the announcement is not left waiting for the timeout
+        dispatcherWaiting.store(true);
+        if (drainToSinks(false) == 0 && dispatcherRunning.load()) {
+            idleSinks();
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        }
+        dispatcherWaiting.store(false);
     }
-}
\ No newline at end of file
+
+    // Bounded, so producers that keep logging cannot hold the task here
+    drainToSinks(true);
+    dispatcherTask.store(nullptr);
+    vTaskDelete(NULL);
+}
@@ -1,41 +1,130 @@
 /**
  * @file ESPLogger.h
  * @brief Thread-safe logging system for ESP32 and similar embedded systems.
- * 
+ *
  * This logger implements a circular buffer for storing log messages,
  * supports multiple log levels, and provides both callback and observer
  * patterns for flexible log handling.
- * 
- * @todo Implement configurable buffer sizes
- * @todo Add timestamp information to log entries
- * @todo Implement log rotation or file-based logging for persistence
- * @todo Use compile-time configuration for system-specific optimizations
- * @todo Consider using a more type-safe formatting library
- * @todo Optimize memory usage for callbacks and observers
+ *
+ * Entries are stored as length-prefixed records in a byte ring, so short
+ * messages take less room than long ones. Producers never take a lock: each
+ * reserves room with a compare-and-swap, evicting the oldest records, and
+ * copies its record in; committed records are numbered in position order by
+ * whichever producer finds them next. Readers validate their copy
+ * afterwards, so a slow consumer never holds up the tasks that log. Only
+ * numbered records are evicted, so a producer that finds the ring full of
+ * records still being written drops its entry and counts it
+ * (getBusyDroppedCount) rather than waiting.
+ * With LOGGER_PER_CORE_RINGS each core writes to its own ring and
+ * positions, splitting the same memory, so tasks on different cores never
+ * contend; readers merge the rings in timestamp order.
+ * Sinks (callback, observers, serial output) run inline by default, or on a
+ * dedicated dispatcher task that drains the buffer in batches. Observers are
+ * non-owning function references in a fixed table, so registering one does
+ * not allocate and delivering to them takes no lock.
+ *
+ * Building with LOGGER_DEFERRED_FORMAT stores the format string pointer and
+ * the packed arguments instead of the formatted text; formatting then only
+ * happens when an entry is read or delivered to a sink. In that mode format
+ * strings must outlive the entry (string literals do). Unformatted messages
+ * are stored as text, and a string argument too long for the packed bytes is
+ * shortened, never the arguments after it; either way the entry gets the
+ * overflow marker.
+ *
+ * LOGGER_MIN_LEVEL sets the lowest level compiled into the firmware. The
+ * LOGGER_DEBUG/INFO/WARNING/ERROR macros remove calls below it entirely,
+ * including the evaluation of their arguments; setFilterLevel and per-tag
+ * overrides (setTagLevel) still filter at runtime above that floor.
+ *
+ * Tags are interned into a small registry and records only store the tag's
+ * id. The LOGGER_* macros resolve the id once per call site.
+ *
+ * Every entry carries a microsecond timestamp since boot. Wall-clock time is
+ * derived when entries are read, from an epoch offset that ESPTimeSetup
+ * refreshes on each clock synchronization.
+ *
+ * The buffer layout is a template: BasicLogger<Capacity, MsgSize, TagSize,
+ * Allocator>. Logger is the instantiation used by the library wrappers and
+ * can be resized with LOGGER_CAPACITY, LOGGER_MESSAGE_SIZE, LOGGER_TAG_SIZE
+ * and moved to PSRAM with LOGGER_USE_PSRAM.
+ *
+ * logFormat and the LOGGER_FMT macros take "{}" placeholders instead of
+ * printf specifiers (see ESPBraceFormat.h); the macros reject a literal
+ * format whose placeholder count does not match the arguments at compile
+ * time.
+ *
  * @todo Add utility methods for logging exceptions and stack traces
  */
 
 #ifndef ESP_LOGGER_H
 #define ESP_LOGGER_H
 
-#include <array>
 #include <string>
 #include <string_view>
-#include <functional>
+#include <memory>
 #include <mutex>
 #include <atomic>
 #include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
 #include <ArduinoJson.h>
+#include "ESPBraceFormat.h"
+#include "ESPFunctionRef.h"
+#include "ESPLogFormat.h"
+#include "ESPLogWire.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #ifdef ENABLE_SERIAL_PRINT
 #include <Arduino.h>
 #endif
 
+#ifndef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL 0 ///< Lowest level compiled in: 0 DEBUG, 1 INFO, 2 WARNING, 3 ERROR
+#endif
+
+#ifndef LOGGER_DEFERRED_ARGS_SIZE
+#define LOGGER_DEFERRED_ARGS_SIZE 64 ///< Bytes of packed arguments kept per entry in deferred mode, raised to LOGGER_MESSAGE_SIZE if smaller
+#endif
+
+#ifndef LOGGER_CAPACITY
+#define LOGGER_CAPACITY 100 ///< Number of entries held by Logger
+#endif
+
+#ifndef LOGGER_MESSAGE_SIZE
+#define LOGGER_MESSAGE_SIZE 156 ///< Maximum size of a Logger message
+#endif
+
+#ifndef LOGGER_TAG_SIZE
+#define LOGGER_TAG_SIZE 20 ///< Maximum size of a Logger tag
+#endif
+
+#ifndef LOGGER_MAX_TAGS
+#define LOGGER_MAX_TAGS 32 ///< Number of distinct tags a logger can register
+#endif
+
+#ifndef LOGGER_FIELDS_SIZE
+#define LOGGER_FIELDS_SIZE 64 ///< Bytes of packed key/value fields kept per entry
+#endif
+
+#ifndef LOGGER_MAX_OBSERVERS
+#define LOGGER_MAX_OBSERVERS 4 ///< Number of observers, including the one set by setCallback
+#endif
+
+#ifndef LOGGER_MAX_READERS
+#define LOGGER_MAX_READERS 4 ///< Number of read cursors, including the one used by getNextLog
+#endif
+
 /**
- * @class Logger
- * @brief Main logger class implementing a thread-safe circular buffer for log messages.
+ * @class LoggerBase
+ * @brief Layout-independent part of the logger: levels, callbacks, observers and the dispatcher task.
  */
-class Logger {
+class LoggerBase {
 public:
     /**
      * @enum Level
@@ -43,29 +132,169 @@ public:
      */
     enum class Level { DEBUG, INFO, WARNING, ERROR };
 
-    static constexpr size_t MAX_LOGS = 100; ///< Maximum number of logs in the circular buffer
-    static constexpr size_t LOG_SIZE = 156; ///< Maximum size of a log message
-    static constexpr size_t TAG_SIZE = 20;  ///< Maximum size of a log tag
     static constexpr std::string_view DEFAULT_TAG = "DEFAULT"; ///< Default tag for logs
     static constexpr std::string_view OVERFLOW_MSG = " [LOG OVERFLOW]"; ///< Message appended when a log message is truncated
+    static constexpr Level MIN_LEVEL = static_cast<Level>(LOGGER_MIN_LEVEL); ///< Lowest level compiled in
+
+    /**
+     * @brief Check whether a level survives the compile-time floor.
+     * @param level Level to check.
+     * @return true if calls at this level are compiled in.
+     */
+    static constexpr bool isCompiledIn(Level level) {
+        return level >= MIN_LEVEL;
+    }
+
+    /**
+     * @enum OverflowPolicy
+     * @brief Behaviour of producers when the dispatcher falls a full buffer behind.
+     */
+    enum class OverflowPolicy {
+        DROP,  /**< Overwrite entries the dispatcher has not delivered yet */
+        BLOCK  /**< Wait up to blockTimeout for the dispatcher to catch up */
+    };
+
+    /**
+     * @enum ExportFormat
+     * @brief Layout of entries written by exportLogs.
+     */
+    enum class ExportFormat {
+        JSON_ARRAY, /**< One JSON array holding every exported entry */
+        NDJSON      /**< One JSON object per line */
+    };
+
+    /**
+     * @struct DispatcherConfig
+     * @brief Configuration of the asynchronous sink dispatcher task.
+     */
+    struct DispatcherConfig {
+        UBaseType_t priority = 1;            /**< FreeRTOS priority of the dispatcher task */
+        BaseType_t core = tskNO_AFFINITY;    /**< Core the task is pinned to */
+        uint32_t stackSize = 4096;           /**< Stack size of the dispatcher task */
+        size_t batchSize = 8;                /**< Maximum entries delivered per sink call */
+        OverflowPolicy policy = OverflowPolicy::DROP; /**< Behaviour when sinks fall behind */
+        uint32_t blockTimeout = 10;          /**< Maximum time in ms a producer waits under BLOCK */
+    };
+
+    /**
+     * @struct SuppressionConfig
+     * @brief Configuration of duplicate suppression and per-tag rate limiting.
+     */
+    struct SuppressionConfig {
+        bool collapseRepeats = true;  /**< Count repeats of a tag's last (tag, format) instead of storing them */
+        uint32_t repeatWindow = 60000; /**< Longest time in ms repeats are collapsed before logging again */
+        uint32_t burst = 20;          /**< Records a tag may log back to back, 0 disables rate limiting */
+        uint32_t ratePerSecond = 5;   /**< Records per second a tag regains after a burst */
+    };
+
+    static constexpr size_t MAX_OBSERVERS = LOGGER_MAX_OBSERVERS; ///< Number of observer slots
 
     /**
-     * @brief Get the singleton instance of the Logger.
-     * @return Reference to the Logger instance.
+     * @typedef Observer
+     * @brief Non-owning reference to a function taking tag, level and message.
+     *
+     * Function pointers and captureless lambdas can be passed directly; other
+     * callables must outlive their registration.
      */
-    static Logger& instance();
+    using Observer = FunctionRef<void(std::string_view, Level, std::string_view)>;
+
+    using ObserverHandle = uint32_t; ///< Identifies a registered observer for removal
+    static constexpr ObserverHandle INVALID_OBSERVER = 0; ///< Returned when the observer table is full
 
     /**
      * @brief Set a callback function to be called for each log entry.
+     *
+     * Replaces the callback set by a previous call; uses one observer slot.
      * @param cb Callback function taking tag, level, and message as parameters.
      */
-    void setCallback(std::function<void(std::string_view, Level, std::string_view)> cb);
+    void setCallback(Observer cb);
 
     /**
      * @brief Add an observer function to be called for each log entry.
+     *
+     * Observers may run concurrently on several tasks when entries are
+     * delivered inline, so they must be thread-safe.
      * @param observer Observer function taking tag, level, and message as parameters.
+     * @return Handle for removeLogObserver, or INVALID_OBSERVER if all MAX_OBSERVERS slots are in use.
+     */
+    ObserverHandle addLogObserver(Observer observer);
+
+    /**
+     * @brief Remove an observer and wait until no call to it is in progress.
+     *
+     * Must not be called from inside an observer.
+     * @param handle Handle returned by addLogObserver; stale handles are ignored.
+     * @return true if the observer was registered.
+     */
+    bool removeLogObserver(ObserverHandle handle);
+
+    /**
+     * @class Mirror
+     * @brief Receives every stored entry synchronously, on the task that logged it.
+     *
+     * Unlike sinks a mirror is never deferred to the dispatcher, so it sees
+     * an entry even if the device resets right after logging it. Keep the
+     * implementation short; it runs inside every log call.
+     */
+    class Mirror {
+    public:
+        virtual ~Mirror() = default;
+
+        /**
+         * @brief Record one entry.
+         * @param tag Tag of the entry.
+         * @param level Severity level of the entry.
+         * @param message Formatted message of the entry.
+         */
+        virtual void mirror(const char* tag, Level level, const char* message) = 0;
+    };
+
+    /**
+     * @brief Set the mirror that receives every stored entry.
+     * @param target Mirror to use, nullptr to remove it; must outlive the logger.
+     */
+    void setMirror(Mirror* target);
+
+    /**
+     * @brief Start delivering entries to sinks from a dedicated task.
+     *
+     * Once started, logging only stores the entry and wakes the dispatcher,
+     * which drains the buffer and hands entries to the sinks in batches.
+     * @param config Task and overflow configuration.
+     * @return true if the task was created, false if it was already running or creation failed.
+     */
+    bool startDispatcher(const DispatcherConfig& config);
+
+    /**
+     * @brief Stop the dispatcher task and return to inline sink delivery.
+     *
+     * Entries logged while the dispatcher is stopping may not reach the sinks.
+     */
+    void stopDispatcher();
+
+    /**
+     * @brief Get the number of entries overwritten before the dispatcher delivered them.
+     * @return Number of entries the sinks never received.
+     */
+    size_t getSinkDroppedCount() const;
+
+    /**
+     * @brief Get the number of records collapsed into a repeat count.
+     * @return Number of repeats not stored individually.
      */
-    void addLogObserver(std::function<void(std::string_view, Level, std::string_view)> observer);
+    size_t getRepeatSuppressedCount() const;
+
+    /**
+     * @brief Get the number of records dropped by the per-tag rate limit.
+     * @return Number of rate-limited records.
+     */
+    size_t getRateLimitedCount() const;
+
+    /**
+     * @brief Get the number of records dropped because the ring was full of records still being written.
+     * @return Number of records that found no room.
+     */
+    size_t getBusyDroppedCount() const;
 
     /**
      * @brief Set the minimum log level to be processed.
@@ -73,8 +302,356 @@ public:
      */
     void setFilterLevel(Level level);
 
+    /**
+     * @brief Get the printable name of a level.
+     * @param level Level to name.
+     * @return Upper-case level name.
+     */
+    static const char* levelToString(Level level);
+
+    /**
+     * @brief Parse a level name as printed by levelToString, ignoring case.
+     * @param name Level name.
+     * @param level Set to the parsed level on success.
+     * @return true if the name is a known level.
+     */
+    static bool parseLevel(std::string_view name, Level& level);
+
+    /**
+     * @brief Set the offset between entry timestamps and wall-clock time.
+     *
+     * Called by ESPTimeSetup whenever the clock is synchronized, so logging
+     * itself never has to query the wall clock.
+     * @param offset Microseconds since the Unix epoch at boot, 0 if unknown.
+     */
+    void setEpochOffset(int64_t offset);
+
+    /**
+     * @brief Convert an entry timestamp to wall-clock time.
+     * @param timestamp Microseconds since boot, as stored in LogEntry::timestamp.
+     * @return Microseconds since the Unix epoch, or 0 if the clock was never synchronized.
+     */
+    int64_t toEpochTime(int64_t timestamp) const;
+
+protected:
+    LoggerBase() = default;
+    virtual ~LoggerBase() = default;
+    LoggerBase(const LoggerBase&) = delete; ///< Deleted copy constructor
+    LoggerBase& operator=(const LoggerBase&) = delete; ///< Deleted assignment operator
+
+    /**
+     * @brief Check whether the caller's next record could evict one the dispatcher has not read.
+     * @return true if the ring the caller writes to has no room left.
+     */
+    virtual bool dispatchBacklogFull() const = 0;
+
+    /**
+     * @brief Allocate the dispatcher batch buffer and start delivery at the current write position.
+     * @param batchSize Number of entries per batch.
+     */
+    virtual void prepareDispatch(size_t batchSize) = 0;
+
+    /**
+     * @brief Deliver committed entries to the sinks in batches from the dispatcher task.
+     * @param bounded Stop at the records written when the call started instead of when none are left.
+     * @return Number of entries delivered.
+     */
+    virtual size_t drainToSinks(bool bounded) = 0;
+
+    /**
+     * @brief Give every batch sink a chance to write out what it holds while the dispatcher is idle.
+     */
+    virtual void idleSinks() = 0;
+
+    /**
+     * @brief Run the callback, observers and serial output for one entry.
+     * @param tag Tag of the entry.
+     * @param level Severity level of the entry.
+     * @param message Formatted message of the entry.
+     */
+    void deliverText(const char* tag, Level level, const char* message);
+
+    /**
+     * @brief Check whether an entry logged inline has anyone to deliver it to.
+     * @return true if serial output is enabled or any callback, observer or sink is registered.
+     */
+    bool hasInlineSinks() const;
+
+    /**
+     * @brief Wait, within the configured timeout, until the dispatcher has room for another entry.
+     */
+    void waitForDispatcher();
+
+    /**
+     * @brief Wake the dispatcher if it is waiting for new entries.
+     * @param dispatcher Handle of the dispatcher task.
+     */
+    void notifyDispatcher(TaskHandle_t dispatcher);
+
+    /**
+     * @struct ObserverSlot
+     * @brief One entry of the observer table.
+     *
+     * Delivery counts itself in users before checking active, and removal
+     * clears active before waiting for users to drop to zero, so a removed
+     * observer is never called once removeLogObserver returns.
+     */
+    struct ObserverSlot {
+        Observer observer;                ///< Registered function, written before active is set
+        std::atomic<bool> active{false};  ///< Whether the slot holds an observer
+        std::atomic<uint32_t> users{0};   ///< Deliveries currently inside this slot
+        uint32_t generation = 0;          ///< Bumped on every registration, guarded by observerMutex
+    };
+
+    static_assert(LOGGER_MAX_OBSERVERS > 0 && LOGGER_MAX_OBSERVERS <= UINT8_MAX, "Observer slots must fit in a byte");
+
+    ObserverSlot observerSlots[MAX_OBSERVERS]; ///< Observer table
+    ObserverHandle callbackHandle = INVALID_OBSERVER; ///< Observer set by setCallback, guarded by observerMutex
+    std::mutex observerMutex; ///< Serializes observer registration and removal
+    std::mutex sinkMutex; ///< Serializes batch sinks
+    std::atomic<bool> sinksAttached{false}; ///< Set once any callback, observer or sink is registered
+    std::atomic<Level> filterLevel{Level::DEBUG}; ///< Minimum log level to process
+    std::atomic<int64_t> epochOffset{0}; ///< Unix time in microseconds at boot, 0 until synchronized
+    std::atomic<Mirror*> mirror{nullptr}; ///< Synchronous copy of every stored entry, if set
+
+    DispatcherConfig dispatcherConfig; ///< Configuration of the running dispatcher
+    std::atomic<TaskHandle_t> dispatcherTask{nullptr}; ///< Dispatcher task, null until created and after it exits
+    std::atomic<bool> dispatcherRunning{false}; ///< Set once the dispatcher's start cursor is taken, cleared to ask it to exit
+    std::atomic<bool> dispatcherWaiting{false}; ///< Set while the dispatcher waits for a notification
+    std::atomic<size_t> sinkDropped{0}; ///< Entries overwritten before the dispatcher read them
+
+    SuppressionConfig suppressionConfig; ///< Active suppression settings, guarded by suppressionLock
+    std::atomic<bool> suppressionActive{false}; ///< Set while suppression is enabled
+    portMUX_TYPE suppressionLock = portMUX_INITIALIZER_UNLOCKED; ///< Guards the per-tag suppression state
+    std::atomic<size_t> repeatSuppressed{0}; ///< Records collapsed into a repeat count
+    std::atomic<size_t> rateLimited{0}; ///< Records dropped by the rate limit
+    std::atomic<size_t> busyDropped{0}; ///< Records that found the ring full of unnumbered records
+
+private:
+    static void dispatcherTaskWrapper(void* pvParameters);
+    void dispatcherLoop();
+};
+
+/**
+ * @class PsramAllocator
+ * @brief Allocator placing the log buffer in external PSRAM, falling back to internal RAM.
+ */
+template<typename T>
+class PsramAllocator {
+public:
+    using value_type = T;
+
+    PsramAllocator() = default;
+    template<typename U>
+    PsramAllocator(const PsramAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        void* memory = heap_caps_malloc(n * sizeof(T), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (memory == nullptr) {
+            memory = heap_caps_malloc(n * sizeof(T), MALLOC_CAP_8BIT);
+        }
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* pointer, size_t) {
+        heap_caps_free(pointer);
+    }
+
+    template<typename U>
+    bool operator==(const PsramAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const PsramAllocator<U>&) const { return false; }
+};
+
+/**
+ * @class BasicLogger
+ * @brief Main logger class implementing a thread-safe circular buffer for log messages.
+ * @tparam Capacity Number of maximum-size entries the ring holds at least; shorter entries take less room.
+ * @tparam MsgSize Maximum size of a log message, including the terminator.
+ * @tparam TagSize Maximum size of a log tag, including the terminator.
+ * @tparam Allocator Allocator used for the buffer, e.g. PsramAllocator to place it in PSRAM.
+ */
+template<size_t Capacity, size_t MsgSize, size_t TagSize, typename Allocator = std::allocator<uint8_t>>
+class BasicLogger : public LoggerBase {
+    static_assert(Capacity > 0, "Logger capacity must not be zero");
+    static_assert(MsgSize > OVERFLOW_MSG.length() + 1, "Logger message size too small for the overflow marker");
+    static_assert(TagSize > 1, "Logger tag size too small");
+    static_assert(LOGGER_MAX_TAGS > 0 && LOGGER_MAX_TAGS <= UINT8_MAX + 1, "Tag ids must fit in a byte");
+    static_assert(LOGGER_FIELDS_SIZE <= UINT8_MAX, "Field length must fit in a byte");
+    static_assert(LOGGER_MAX_READERS > 0 && LOGGER_MAX_READERS < UINT8_MAX, "Reader ids must fit in a byte");
+
+public:
+    static constexpr size_t MAX_LOGS = Capacity; ///< Number of maximum-size logs the ring is sized for
+    static constexpr size_t LOG_SIZE = MsgSize;  ///< Maximum size of a log message
+    static constexpr size_t TAG_SIZE = TagSize;  ///< Maximum size of a log tag
+    static constexpr size_t MAX_TAGS = LOGGER_MAX_TAGS; ///< Number of distinct tags that can be registered
+    static constexpr size_t FIELDS_SIZE = LOGGER_FIELDS_SIZE; ///< Bytes of packed fields kept per entry
+
+    using TagId = uint8_t; ///< Index of a registered tag
+    static constexpr TagId DEFAULT_TAG_ID = 0; ///< Id of DEFAULT_TAG, also used once the registry is full
+    static constexpr uint8_t INHERIT_LEVEL = UINT8_MAX; ///< Tag level meaning "use the global filter level"
+
+    static constexpr size_t MAX_READERS = LOGGER_MAX_READERS; ///< Number of read cursors
+    using ReaderId = uint8_t; ///< Index of a registered read cursor
+    static constexpr ReaderId DEFAULT_READER = 0; ///< Reader used by getNextLog and peekNextLog
+    static constexpr ReaderId INVALID_READER = UINT8_MAX; ///< Returned by addReader when all cursors are in use
+
+    /**
+     * @class Tag
+     * @brief Tag resolved to its registry id on construction.
+     *
+     * Keep one per call site (the LOGGER_* macros use a function-local
+     * static) so the name is only looked up once.
+     */
+    class Tag {
+    public:
+        /**
+         * @brief Register a tag name, or find it if already registered.
+         * @param name Tag name; truncated to TAG_SIZE - 1 characters.
+         */
+        explicit Tag(std::string_view name) : id(instance().registerTag(name)) {}
+
+        TagId id; ///< Registry id of the tag
+    };
+
+    /**
+     * @struct LogEntry
+     * @brief Structure representing a single log entry.
+     */
+    struct LogEntry {
+        char tag[TAG_SIZE];  ///< Tag of the log entry
+        Level level;         ///< Severity level of the log entry
+        int64_t timestamp;   ///< Microseconds since boot when the entry was stored
+        char message[LOG_SIZE]; ///< Content of the log message
+        uint8_t fieldsLength = 0; ///< Number of bytes used in fields
+        uint8_t fields[FIELDS_SIZE]; ///< Key/value fields packed by LogFormat::packFields
+    };
+
+    /**
+     * @class Sink
+     * @brief Interface for destinations that receive log entries in batches.
+     */
+    class Sink {
+    public:
+        virtual ~Sink() = default;
+
+        /**
+         * @brief Deliver consecutive log entries to the sink.
+         * @param entries Pointer to the first entry.
+         * @param count Number of entries.
+         */
+        virtual void write(const LogEntry* entries, size_t count) = 0;
+
+        /**
+         * @brief Called by the dispatcher when it has no entries to deliver.
+         *
+         * Lets sinks that batch entries write them out once logging goes quiet.
+         */
+        virtual void idle() {}
+    };
+
+    /**
+     * @brief Get the singleton instance of this logger layout.
+     * @return Reference to the logger instance.
+     */
+    static BasicLogger& instance();
+
+    /**
+     * @brief Get the size of the record ring allocated for this layout.
+     * @return Ring size in bytes, excluding the logger object itself.
+     */
+    static constexpr size_t getBufferSize() {
+        return RING_COUNT * RING_WORDS * WORD_SIZE;
+    }
+
+    /**
+     * @brief Register a sink that receives every log entry.
+     * @param sink Sink to register; must outlive the logger.
+     */
+    void addSink(Sink& sink);
+
+    /**
+     * @brief Intern a tag name.
+     * @param name Tag name; truncated to TAG_SIZE - 1 characters.
+     * @return Id of the tag, or DEFAULT_TAG_ID if the registry is full.
+     */
+    TagId registerTag(std::string_view name);
+
+    /**
+     * @brief Get the name of a registered tag.
+     * @param id Tag id.
+     * @return Tag name, or DEFAULT_TAG if the id is not registered.
+     */
+    const char* getTagName(TagId id) const;
+
+    /**
+     * @brief Override the filter level for one tag.
+     *
+     * The tag is registered if needed, so levels can be set before the tag
+     * first logs. The override applies instead of the global filter level,
+     * in either direction.
+     * @param tag Tag name.
+     * @param level Minimum log level for this tag.
+     */
+    void setTagLevel(std::string_view tag, Level level);
+
+    /**
+     * @brief Remove the filter level override of a tag.
+     * @param tag Tag name.
+     */
+    void clearTagLevel(std::string_view tag);
+
+    /**
+     * @brief Apply filter levels from a text command.
+     *
+     * The command is a comma separated list of tag=LEVEL pairs, for example
+     * "MQTTManager=DEBUG,WiFi=ERROR". The tag "*" sets the global filter
+     * level, and an empty level ("WiFi=") clears a tag override. Suitable
+     * as the handler of an MQTT command topic.
+     * @param command Level assignments.
+     * @return true if every assignment was valid; valid ones are applied either way.
+     */
+    bool applyLevelCommand(std::string_view command);
+
+    /**
+     * @brief Start collapsing repeated records and rate limiting each tag.
+     *
+     * Both checks run before formatting. A record with the same tag and
+     * format string (or the same text, for unformatted messages) as that
+     * tag's previous record is only counted; the next different record,
+     * or a repeat after repeatWindow, first logs "Previous message repeated
+     * N times". If the tag logs nothing else, the count is logged once
+     * repeatWindow has passed, by the next log call, read, export or
+     * dispatcher pass after that. Each tag also gets a token bucket of burst records refilled
+     * at ratePerSecond; records beyond it are dropped and counted.
+     * @param config Suppression settings.
+     */
+    void enableSuppression(const SuppressionConfig& config);
+
+    /**
+     * @brief Stop suppressing records. Pending repeat counts are discarded.
+     */
+    void disableSuppression();
+
+    /**
+     * @brief Check whether an entry would pass the runtime filter.
+     * @param tag Registry id of the tag.
+     * @param level Severity level of the entry.
+     * @return true if the tag override, or the global level without one, lets the level through.
+     */
+    bool isEnabled(TagId tag, Level level) const {
+        uint8_t threshold = tagLevels[tag].load(std::memory_order_relaxed);
+        if (threshold == INHERIT_LEVEL) {
+            return level >= filterLevel.load(std::memory_order_relaxed);
+        }
+        return static_cast<uint8_t>(level) >= threshold;
+    }
+
     /**
      * @brief Log a message with formatting.
+     *
+     * The tag is looked up in the registry on every call; prefer the
+     * LOGGER_* macros or a Tag kept by the caller.
      * @param tag Tag for the log entry.
      * @param level Severity level of the log.
      * @param format Format string for the log message.
@@ -82,10 +659,37 @@ public:
      */
     template<typename... Args>
     void log(std::string_view tag, Level level, const char* format, Args&&... args) {
-        if (level >= filterLevel.load(std::memory_order_relaxed)) {
+        if (isCompiledIn(level)) {
+            log(Tag(tag), level, format, std::forward<Args>(args)...);
+        }
+    }
+
+    /**
+     * @brief Log a message with formatting under an interned tag.
+     * @param tag Interned tag for the log entry.
+     * @param level Severity level of the log.
+     * @param format Format string for the log message.
+     * @param args Arguments to be formatted into the log message.
+     */
+    template<typename... Args>
+    void log(const Tag& tag, Level level, const char* format, Args&&... args) {
+        if (isCompiledIn(level) && isEnabled(tag.id, level) && admit(tag.id, level, format, false)) {
+#ifdef LOGGER_DEFERRED_FORMAT
+            Record record;
+            record.format = format;
+            LogFormat::ArgPacker packer(record.args, ARGS_SIZE);
+            packer.addAll(args...);
+            record.argsLength = static_cast<uint16_t>(packer.size());
+            record.truncated = packer.truncated();
+            addRecord(tag.id, level, record);
+#else
             char message[LOG_SIZE];
-            snprintf(message, sizeof(message), format, std::forward<Args>(args)...);
-            addLog(tag, level, message);
+            int length = snprintf(message, sizeof(message), format, std::forward<Args>(args)...);
+            if (length >= static_cast<int>(LOG_SIZE)) {
+                markOverflow(message, LOG_SIZE - 1);
+            }
+            addLog(tag.id, level, message);
+#endif
         }
     }
 
@@ -97,16 +701,94 @@ public:
      */
     void log(std::string_view tag, Level level, const char* message);
 
-    
     /**
-     * @struct LogEntry
-     * @brief Structure representing a single log entry.
+     * @brief Overload, Log a message without formatting under an interned tag.
+     * @param tag Interned tag for the log entry.
+     * @param level Severity level of the log.
+     * @param message Content of the log message.
      */
-    struct LogEntry {
-        char tag[TAG_SIZE];  ///< Tag of the log entry
-        Level level;         ///< Severity level of the log entry
-        char message[LOG_SIZE]; ///< Content of the log message
-    };
+    void log(const Tag& tag, Level level, const char* message);
+
+    /**
+     * @brief Log a message with "{}" placeholders.
+     *
+     * Arguments are formatted by type with BraceFormat, so no printf
+     * specifiers are involved. The text is always formatted immediately,
+     * including in deferred mode.
+     * @param tag Tag for the log entry.
+     * @param level Severity level of the log.
+     * @param format Format string with one "{}" per argument.
+     * @param args Arguments to be formatted into the log message.
+     */
+    template<typename... Args>
+    void logFormat(std::string_view tag, Level level, const char* format, const Args&... args) {
+        if (isCompiledIn(level)) {
+            logFormat(Tag(tag), level, format, args...);
+        }
+    }
+
+    /**
+     * @brief Log a message with "{}" placeholders under an interned tag.
+     * @param tag Interned tag for the log entry.
+     * @param level Severity level of the log.
+     * @param format Format string with one "{}" per argument.
+     * @param args Arguments to be formatted into the log message.
+     */
+    template<typename... Args>
+    void logFormat(const Tag& tag, Level level, const char* format, const Args&... args) {
+        if (isCompiledIn(level) && isEnabled(tag.id, level) && admit(tag.id, level, format, false)) {
+            char message[LOG_SIZE];
+            BraceFormat::format(message, sizeof(message), format, args...);
+            addLog(tag.id, level, message);
+        }
+    }
+
+    /**
+     * @brief Create a typed key/value field for logFields.
+     * @param key Field name.
+     * @param value Integer, floating point, enum, pointer or string value.
+     * @return Field referring to the value for the duration of the call.
+     */
+    template<typename T>
+    static LogFormat::Field<T> field(const char* key, const T& value) {
+        return {key, value};
+    }
+
+    /**
+     * @brief Log a message with structured key/value fields.
+     *
+     * The message is stored as is and the fields are packed with their
+     * types, without printf formatting. JSON output carries them as a
+     * "fields" object; text outputs show them as " key=value" after the
+     * message. Fields beyond FIELDS_SIZE packed bytes are left out.
+     * @param tag Tag for the log entry.
+     * @param level Severity level of the log.
+     * @param message Content of the log message.
+     * @param fields Fields created with field().
+     */
+    template<typename... Values>
+    void logFields(std::string_view tag, Level level, const char* message, const LogFormat::Field<Values>&... fields) {
+        if (isCompiledIn(level)) {
+            logFields(Tag(tag), level, message, fields...);
+        }
+    }
+
+    /**
+     * @brief Log a message with structured key/value fields under an interned tag.
+     * @param tag Interned tag for the log entry.
+     * @param level Severity level of the log.
+     * @param message Content of the log message.
+     * @param fields Fields created with field().
+     */
+    template<typename... Values>
+    void logFields(const Tag& tag, Level level, const char* message, const LogFormat::Field<Values>&... fields) {
+        if (isCompiledIn(level) && isEnabled(tag.id, level) && admit(tag.id, level, message, true)) {
+            Record record;
+            setMessage(record, message);
+            record.fieldsLength = static_cast<uint8_t>(LogFormat::packFields(record.fields, sizeof(record.fields), fields...));
+            addRecord(tag.id, level, record);
+        }
+    }
 
     /**
      * @brief Retrieve and remove the next log entry from the buffer.
@@ -124,20 +806,20 @@ public:
     /**
      * @brief View a log entry without removing it from the buffer.
      * @param entry Reference to a LogEntry structure to be filled.
-     * @param offset Offset from the oldest log entry (default is 0).
+     * @param offset Offset from the entry getNextLog returns next (default is 0).
      * @return true if a log entry was retrieved, false if the offset is out of range.
      */
     bool peekNextLog(LogEntry& entry, size_t offset = 0);
 
     /**
      * @brief View a log entry as a JSON string without removing it from the buffer.
-     * @param offset Offset from the oldest log entry (default is 0).
+     * @param offset Offset from the entry getNextLog returns next (default is 0).
      * @return JSON string representation of the log entry, or empty string if offset is out of range.
      */
     String peekNextLogJson(size_t offset = 0);
 
     /**
-     * @brief Get the number of valid log entries in the buffer.
+     * @brief Get the number of valid log entries not yet returned by getNextLog.
      * @return Number of valid log entries.
      */
     size_t getValidLogCount() const;
@@ -148,34 +830,1880 @@ public:
      */
     size_t getLogCount() const;
 
-private:
-    std::array<LogEntry, MAX_LOGS> buffer; ///< Circular buffer for storing log entries
-    std::atomic<size_t> head{0};  ///< Index of the next position to write a log entry
-    std::atomic<size_t> tail{0};  ///< Index of the oldest log entry
-    std::atomic<size_t> count{0}; ///< Number of log entries currently in the buffer
-    std::atomic<size_t> firstLogIndex{0}; ///< Index of the first valid log entry
-    std::function<void(std::string_view, Level, std::string_view)> callback; ///< Callback function for log entries
-    std::vector<std::function<void(std::string_view, Level, std::string_view)>> observers; ///< List of observer functions
-    mutable std::mutex logMutex; ///< Mutex for thread-safe operations
-    std::atomic<Level> filterLevel{Level::DEBUG}; ///< Minimum log level to process
+    /**
+     * @brief Get the number of entries overwritten before getNextLog returned them.
+     * @return Number of dropped log entries.
+     */
+    size_t getDroppedCount() const;
+
+    /**
+     * @brief Register an independent read cursor over the buffer.
+     *
+     * Every reader sees every entry stored while it is registered, unless
+     * the entry is overwritten first; reading does not affect other readers
+     * or getNextLog.
+     * @param fromOldest Start at the oldest entry still buffered instead of the next one stored.
+     * @return Id of the reader, or INVALID_READER if all MAX_READERS cursors are in use.
+     */
+    ReaderId addReader(bool fromOldest = true);
+
+    /**
+     * @brief Release a read cursor so its slot can be reused.
+     * @param reader Id returned by addReader; DEFAULT_READER cannot be removed.
+     */
+    void removeReader(ReaderId reader);
+
+    /**
+     * @brief Retrieve the next log entry for a reader and advance its cursor.
+     * @param reader Id returned by addReader.
+     * @param entry Reference to a LogEntry structure to be filled.
+     * @return true if a log entry was retrieved, false if the reader is up to date or not registered.
+     */
+    bool readLog(ReaderId reader, LogEntry& entry);
+
+    /**
+     * @brief View a log entry ahead of a reader without advancing its cursor.
+     * @param reader Id returned by addReader.
+     * @param entry Reference to a LogEntry structure to be filled.
+     * @param offset Offset from the entry readLog returns next (default is 0).
+     * @return true if a log entry was retrieved, false if the offset is out of range.
+     */
+    bool peekLog(ReaderId reader, LogEntry& entry, size_t offset = 0);
+
+    /**
+     * @brief Get the number of valid log entries a reader has not read yet.
+     * @param reader Id returned by addReader.
+     * @return Number of unread entries still in the buffer.
+     */
+    size_t getPendingCount(ReaderId reader) const;
+
+    /**
+     * @brief Get the number of entries overwritten before a reader read them.
+     * @param reader Id returned by addReader.
+     * @return Number of entries the reader lost.
+     */
+    size_t getLostCount(ReaderId reader) const;
+
+    /**
+     * @brief Write the next entries of a reader to a stream as JSON.
+     *
+     * Holds the reader's lock once for the whole batch and formats every
+     * entry on the stack, so no String or JsonDocument is created. Objects
+     * have the same fields as getNextLogJson.
+     * @param out Destination stream, e.g. Serial or a network client.
+     * @param maxEntries Maximum number of entries to export.
+     * @param format JSON array or newline-delimited objects.
+     * @param reader Reader whose cursor is advanced (default is the one used by getNextLog).
+     * @return Number of entries exported.
+     */
+    size_t exportLogs(Print& out, size_t maxEntries = SIZE_MAX, ExportFormat format = ExportFormat::NDJSON,
+                      ReaderId reader = DEFAULT_READER);
+
+    /**
+     * @brief Write the next entries of a reader into a caller-provided buffer as JSON.
+     *
+     * Only whole entries are written; the first one that does not fit stays
+     * unread for the next call. The output is always terminated.
+     * @param buffer Destination buffer.
+     * @param size Size of the destination buffer.
+     * @param length Set to the number of bytes written, excluding the terminator.
+     * @param maxEntries Maximum number of entries to export.
+     * @param format JSON array or newline-delimited objects.
+     * @param reader Reader whose cursor is advanced (default is the one used by getNextLog).
+     * @return Number of entries exported.
+     */
+    size_t exportLogs(char* buffer, size_t size, size_t& length, size_t maxEntries = SIZE_MAX,
+                      ExportFormat format = ExportFormat::NDJSON, ReaderId reader = DEFAULT_READER);
+
+    /**
+     * @brief Write the next entries of a reader into a buffer in the LogWire binary format.
+     *
+     * Deferred entries are sent as format id and packed arguments, so they
+     * are never formatted on the device. Only whole entries are written, so
+     * size the buffer for at least one entry with its tag and format definitions.
+     * @param encoder Stream state; call encoder.reset() to make this buffer decodable on its own.
+     * @param buffer Destination buffer.
+     * @param size Size of the destination buffer.
+     * @param length Set to the number of bytes written.
+     * @param maxEntries Maximum number of entries to export.
+     * @param reader Reader whose cursor is advanced (default is the one used by getNextLog).
+     * @return Number of entries exported.
+     */
+    size_t exportBinary(LogWire::Encoder& encoder, uint8_t* buffer, size_t size, size_t& length,
+                        size_t maxEntries = SIZE_MAX, ReaderId reader = DEFAULT_READER);
+
+private:
+    /**
+     * @enum ReadStatus
+     * @brief Outcome of reading a ring position.
+     */
+    enum class ReadStatus { READY, OVERWRITTEN };
+
+#ifdef LOGGER_DEFERRED_FORMAT
+    /**
+     * @struct Record
+     * @brief Stored form of an entry whose message is formatted when read.
+     */
+    /// Room for packed arguments, or for a plain message with its terminator
+    static constexpr size_t ARGS_SIZE = std::max<size_t>(LOGGER_DEFERRED_ARGS_SIZE, LOG_SIZE);
+
+    struct Record {
+        const char* format;  ///< Format string, nullptr when args holds the text of a plain message
+        Level level;         ///< Severity level of the log entry
+        TagId tag;           ///< Registry id of the tag
+        uint16_t argsLength; ///< Number of bytes used in args, excluding the terminator of a plain message
+        bool truncated = false; ///< Set when an argument did not fit in args
+        int64_t timestamp;   ///< Microseconds since boot when the entry was stored
+        uint8_t args[ARGS_SIZE]; ///< Arguments packed by LogFormat::packArgs, or the message text
+        uint8_t fieldsLength = 0; ///< Number of bytes used in fields
+        uint8_t fields[FIELDS_SIZE]; ///< Key/value fields packed by LogFormat::packFields
+    };
+
+    /// Fields with their length byte, format pointer and packed arguments or message text
+    static constexpr size_t MAX_BODY_SIZE = 1 + FIELDS_SIZE + sizeof(const char*) + ARGS_SIZE - 1;
+#else
+    /**
+     * @struct Record
+     * @brief Stored form of an already formatted entry.
+     */
+    struct Record {
+        Level level;         ///< Severity level of the log entry
+        TagId tag;           ///< Registry id of the tag
+        int64_t timestamp;   ///< Microseconds since boot when the entry was stored
+        char message[LOG_SIZE]; ///< Content of the log message
+        uint8_t fieldsLength = 0; ///< Number of bytes used in fields
+        uint8_t fields[FIELDS_SIZE]; ///< Key/value fields packed by LogFormat::packFields
+    };
+
+    static constexpr size_t MAX_BODY_SIZE = 1 + FIELDS_SIZE + LOG_SIZE - 1; ///< Fields with their length byte, message without its terminator
+#endif
+
+    /**
+     * @struct RecordHeader
+     * @brief Fixed part of a record, stored after its size word.
+     *
+     * The body bytes follow without a terminator; the record is padded to a
+     * whole number of words. When FIELDS_FLAG is set in level, the body
+     * starts with the fields length and the packed fields.
+     */
+    struct RecordHeader {
+        uint32_t sequence;   ///< Number of the record since startup, written when the record is numbered
+        uint8_t level;       ///< Severity level of the log entry
+        TagId tag;           ///< Registry id of the tag
+        uint16_t bodyLength; ///< Number of message, or format and argument, bytes
+        int64_t timestamp;   ///< Microseconds since boot, from esp_timer_get_time
+    };
+
+#ifdef LOGGER_PER_CORE_RINGS
+    static constexpr size_t RING_COUNT = portNUM_PROCESSORS; ///< One ring per core
+#else
+    static constexpr size_t RING_COUNT = 1; ///< Number of rings records are spread over
+#endif
+
+    /**
+     * @struct RingCursor
+     * @brief Read position in one ring together with the sequence expected there.
+     */
+    struct RingCursor {
+        uint32_t position = 0; ///< Word position of the next record
+        uint32_t sequence = 0; ///< Sequence number of the next record
+    };
+
+    /**
+     * @struct Cursor
+     * @brief Read position in every ring.
+     *
+     * Sequence numbers are counted per ring; their sum numbers the merged
+     * stream, so it grows by one per record read and by the gap when
+     * records were overwritten.
+     */
+    struct Cursor {
+        RingCursor rings[RING_COUNT]; ///< Position in each ring
+
+        /// Whether any ring of this cursor has records left before the same ring of limit
+        bool before(const Cursor& limit) const {
+            for (size_t i = 0; i < RING_COUNT; ++i) {
+                // Sequence numbers wrap, so compare their signed distance
+                if (static_cast<int32_t>(limit.rings[i].sequence - rings[i].sequence) > 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// Sequence number of the next record in the merged stream
+        uint32_t sequence() const {
+            uint32_t total = 0;
+            for (const RingCursor& ring : rings) {
+                total += ring.sequence;
+            }
+            return total;
+        }
+    };
+
+    static constexpr uint8_t FIELDS_FLAG = 0x80; ///< Set in RecordHeader::level when the record has fields
+    static constexpr uint8_t TRUNCATED_FLAG = 0x40; ///< Set in RecordHeader::level when arguments were cut
+    static constexpr size_t WORD_SIZE = sizeof(uint32_t);
+    static constexpr size_t HEADER_WORDS = 1 + sizeof(RecordHeader) / WORD_SIZE; ///< Size word and header
+    static constexpr size_t MAX_RECORD_WORDS = HEADER_WORDS + (MAX_BODY_SIZE + WORD_SIZE - 1) / WORD_SIZE;
+
+    /**
+     * @brief Round a size up to the next power of two.
+     * @param value Size to round, at least 1.
+     * @return Smallest power of two not below value.
+     */
+    static constexpr size_t ceilPowerOfTwo(size_t value) {
+        size_t power = 1;
+        while (power < value) {
+            power <<= 1;
+        }
+        return power;
+    }
+
+    /// At least the footprint of Capacity fixed-size entries split between the rings, rounded up to a power of
+    /// two so positions map to indices with a mask; fields only take room in the records that have them
+    static constexpr size_t RING_WORDS =
+        ceilPowerOfTwo(Capacity * (sizeof(LogEntry) - sizeof(LogEntry::fields)) / WORD_SIZE / RING_COUNT);
+    /// Keeps rings written from different cores out of each other's cache lines
+    static constexpr size_t RING_ALIGNMENT = RING_COUNT > 1 ? 64 : alignof(std::atomic<size_t>);
+
+    static_assert(sizeof(RecordHeader) % WORD_SIZE == 0, "Record header must be a whole number of words");
+    static_assert(MAX_BODY_SIZE <= UINT16_MAX, "Logger message size too large for a record");
+    static_assert(RING_WORDS >= MAX_RECORD_WORDS, "Logger ring too small for a record");
+    // Positions wrap at 2^32, a multiple of the ring size, so a position keeps its index when it wraps
+    static_assert(RING_WORDS <= (size_t{1} << 30), "Logger ring too large for 32-bit word positions");
+    // Numbering a record then rewrites a single ring word
+    static_assert(offsetof(RecordHeader, sequence) == 0, "Sequence number must be the first header word");
+
+    static constexpr size_t FLAG_WORDS = (RING_WORDS + 31) / 32; ///< Words of commit flags, one bit per ring word
+
+    using WordAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<uint32_t>;
+    using WordTraits = std::allocator_traits<WordAllocator>;
+
+    /**
+     * @struct Ring
+     * @brief Byte ring of length-prefixed records and its write state.
+     *
+     * Producers reserve room by moving head with a compare-and-swap, copy
+     * their record in and set its commit flag. Committed records are then
+     * numbered in position order from the frontier by whichever producer
+     * finds them there; readers and evictions stop at the frontier, so
+     * neither touches a record that is still being written.
+     */
+    struct alignas(RING_ALIGNMENT) Ring {
+        uint32_t* words = nullptr;    ///< RING_WORDS words of records
+        std::atomic<uint32_t> committed[FLAG_WORDS] = {}; ///< Bit per word, set at the start of a written record until it is numbered
+        std::atomic<uint32_t> head{0};  ///< Word position of the next reservation; positions wrap at 2^32
+        std::atomic<uint32_t> start{0}; ///< Word position of the oldest record still in the ring
+        std::atomic<uint32_t> nextSequence{0};  ///< Sequence number given to the record at the frontier
+        std::atomic<uint32_t> frontier[2] = {}; ///< Word position of the first unnumbered record, indexed by nextSequence parity
+        std::atomic<uint32_t> dispatchPosition{0}; ///< Next position the dispatcher delivers
+    };
+
+    WordAllocator wordAllocator;  ///< Allocator owning the memory of all rings
+    Ring rings[RING_COUNT];       ///< Rings, indexed by the core that writes them
+
+    /**
+     * @struct Reader
+     * @brief State of one registered read cursor.
+     */
+    struct Reader {
+        Cursor cursor;                  ///< Next record returned to the reader, guarded by mutex
+        std::atomic<size_t> lost{0};    ///< Entries overwritten before the reader read them
+        bool active = false;            ///< Whether the slot is registered, guarded by mutex
+        mutable std::mutex mutex;       ///< Serializes use of this cursor
+    };
+
+    Reader readers[MAX_READERS];  ///< Read cursors, indexed by ReaderId
+    std::mutex readerMutex;       ///< Serializes reader registration
+    Cursor dispatchCursor;        ///< Next record delivered by the dispatcher task
+    std::vector<Sink*> sinks;     ///< List of batch sinks
+    std::vector<LogEntry> dispatchBatch; ///< Batch buffer owned by the dispatcher task
+    char tagNames[MAX_TAGS][TAG_SIZE] = {}; ///< Registered tag names, indexed by TagId
+    std::atomic<uint8_t> tagLevels[MAX_TAGS]; ///< Per-tag filter level, INHERIT_LEVEL without an override
+
+    /**
+     * @struct TagSuppression
+     * @brief Repeat and rate-limit state of one tag.
+     */
+    struct TagSuppression {
+        bool hasLast;         ///< Whether lastKey holds a record
+        Level lastLevel;      ///< Level of the last stored record
+        uint32_t lastKey;     ///< Format pointer, or text hash, of the last stored record
+        uint32_t repeats;     ///< Repeats of the last record not stored yet
+        int64_t windowStart;  ///< Time in us the last record was stored
+        uint32_t tokens;      ///< Rate limit budget in thousandths of a record
+        int64_t lastRefill;   ///< Time in us the budget was last refilled
+    };
+
+    TagSuppression suppression[MAX_TAGS] = {}; ///< Per-tag suppression state, guarded by suppressionLock
+    int64_t repeatFlushAt = INT64_MAX; ///< Earliest time in us a pending repeat count is due, guarded by suppressionLock
+    std::atomic<size_t> tagCount{0}; ///< Number of registered tags
+    std::mutex tagMutex;          ///< Serializes tag registration
+
+    BasicLogger(); ///< Private constructor for singleton pattern
+    ~BasicLogger() override;
+
+    bool dispatchBacklogFull() const override;
+    void prepareDispatch(size_t batchSize) override;
+    size_t drainToSinks(bool bounded) override;
+    void idleSinks() override;
+
+    /**
+     * @brief Let producers see how far the dispatcher has delivered in each ring.
+     */
+    void publishDispatchPositions();
+
+    /**
+     * @brief Map a word position to its index in the ring.
+     * @param position Word position.
+     * @return Ring index; RING_WORDS is a power of two, so this is a mask.
+     */
+    static constexpr size_t wordIndex(uint32_t position) {
+        return position & (RING_WORDS - 1);
+    }
+
+    /**
+     * @brief Move a word position forward, wrapping at 2^32.
+     * @param position Word position.
+     * @param words Number of words to move by.
+     * @return The new position.
+     */
+    static constexpr uint32_t advance(uint32_t position, size_t words) {
+        return static_cast<uint32_t>(position + words);
+    }
+
+    /**
+     * @brief Count the words from one position forward to another.
+     *
+     * Positions in the ring lie at most RING_WORDS ahead of its start, so a
+     * larger result means to lies behind from, e.g. a record start has
+     * already passed.
+     * @param from Earlier word position.
+     * @param to Later word position.
+     * @return Distance modulo 2^32.
+     */
+    static constexpr uint32_t wordsBetween(uint32_t from, uint32_t to) {
+        return to - from;
+    }
+
+    /**
+     * @brief Get the ring the calling task writes to.
+     * @return Ring of the current core, or the only ring.
+     */
+    static size_t currentRing() {
+        if constexpr (RING_COUNT == 1) {
+            return 0;
+        } else {
+            return static_cast<size_t>(xPortGetCoreID()) % RING_COUNT;
+        }
+    }
+
+    /**
+     * @brief Get the position and sequence number of the first record not yet numbered.
+     *
+     * Takes no lock: a pair read while the frontier moves is read again.
+     * @param ring Ring to inspect.
+     * @param sequence Set to the sequence number that record will get.
+     * @return Word position of the frontier; records before it are numbered.
+     */
+    static uint32_t frontierOf(const Ring& ring, uint32_t& sequence);
+
+    /**
+     * @brief Get the position and sequence number of the oldest record still in a ring.
+     * @param ring Ring to inspect.
+     * @return Cursor at that record, or at the frontier when no numbered record is left.
+     */
+    static RingCursor oldestIn(const Ring& ring);
+
+    /**
+     * @brief Number the committed records at the frontier of a ring, in position order.
+     *
+     * Any producer does this for the others: whoever clears the commit flag
+     * of the record at the frontier numbers it and moves the frontier past
+     * it, until it reaches a record that is still being written. That
+     * record's producer carries on once it commits.
+     * @param ring Ring to advance.
+     */
+    static void numberRecords(Ring& ring);
+
+    /**
+     * @brief Get a cursor at the oldest record still in each ring.
+     * @return Cursor at the oldest records.
+     */
+    Cursor oldestCursor();
+
+    /**
+     * @brief Get a cursor at the next record to be written in each ring.
+     * @return Cursor at the write positions.
+     */
+    Cursor writeCursor();
+
+    /**
+     * @brief Serialize a record into words, including its size word.
+     * @param record Record to serialize.
+     * @param words Destination of at least MAX_RECORD_WORDS words.
+     * @return Number of words used.
+     */
+    static size_t encode(const Record& record, uint32_t* words);
+
+    /**
+     * @brief Rebuild a record from its serialized words.
+     * @param words Words copied out of the ring, starting with the size word.
+     * @param record Reference to a Record structure to be filled.
+     * @return Sequence number of the record.
+     */
+    static uint32_t decode(const uint32_t* words, Record& record);
+
+    /**
+     * @brief Copy words into a ring, wrapping at its end.
+     * @param ring Ring to write.
+     * @param position Word position of the first word.
+     * @param words Source words.
+     * @param count Number of words.
+     */
+    static void copyIn(Ring& ring, uint32_t position, const uint32_t* words, size_t count);
+
+    /**
+     * @brief Copy words out of a ring, wrapping at its end.
+     * @param ring Ring to read.
+     * @param position Word position of the first word.
+     * @param words Destination words.
+     * @param count Number of words.
+     */
+    static void copyOut(const Ring& ring, uint32_t position, uint32_t* words, size_t count);
+
+    /**
+     * @brief Evict the oldest records of the current core's ring until a record fits and write it.
+     *
+     * Takes no lock. Only numbered records are evicted, so when the ring is
+     * full of records still being written the record is dropped and counted
+     * instead. The timestamp is assigned here and also written back to the
+     * record for the inline sinks and the mirror; the sequence number is
+     * assigned when the record is numbered.
+     * @param record Fully populated record to store.
+     */
+    void publish(Record& record);
+
+    /**
+     * @brief Copy the record stored at a position without taking the reader lock.
+     * @param ring Ring to read.
+     * @param position Word position to read.
+     * @param record Reference to a Record structure to be filled.
+     * @param words Set to the size of the record in words.
+     * @param sequence Set to the sequence number of the record.
+     * @return READY on success, OVERWRITTEN if newer records replaced it.
+     */
+    static ReadStatus readRecord(const Ring& ring, uint32_t position, Record& record, size_t& words, uint32_t& sequence);
+
+    /**
+     * @brief Read the next committed record of one ring.
+     * @param ring Ring to read.
+     * @param cursor Position in that ring; advanced past the returned or skipped records.
+     * @param record Reference to a Record structure to be filled.
+     * @param skipped Incremented by the number of records overwritten before they were read.
+     * @return true if a record was read, false if the cursor reached the write position.
+     */
+    static bool readRing(const Ring& ring, RingCursor& cursor, Record& record, size_t& skipped);
+
+    /**
+     * @brief Get the timestamp of the next committed record of one ring without reading its body.
+     * @param ring Ring to read.
+     * @param cursor Position in that ring; moved to the oldest record if it was overwritten.
+     * @param timestamp Set to the timestamp of the record.
+     * @return true if the ring has a record after the cursor.
+     */
+    static bool peekTimestamp(const Ring& ring, RingCursor& cursor, int64_t& timestamp);
+
+    /**
+     * @brief Read the next committed record after a cursor, the oldest across all rings.
+     * @param cursor Cursor to read from; advanced past the returned or skipped records.
+     * @param record Reference to a Record structure to be filled.
+     * @param skipped Incremented by the number of records overwritten before they were read.
+     * @return true if a record was read, false if the cursor reached the write position of every ring.
+     */
+    bool readNext(Cursor& cursor, Record& record, size_t& skipped) const;
+
+    /**
+     * @brief Read the next committed record after a cursor and format it.
+     * @param cursor Cursor to read from; advanced past the returned or skipped records.
+     * @param entry Reference to a LogEntry structure to be filled.
+     * @param skipped Incremented by the number of records overwritten before they were read.
+     * @return true if an entry was read, false if the cursor reached the write position.
+     */
+    bool readNextEntry(Cursor& cursor, LogEntry& entry, size_t& skipped) const;
+
+    /**
+     * @brief Convert a stored record into a formatted entry.
+     * @param record Record read from the buffer.
+     * @param entry Reference to a LogEntry structure to be filled.
+     */
+    void materialize(const Record& record, LogEntry& entry) const;
+
+    /**
+     * @brief Serialize an entry as a JSON object.
+     * @param entry Entry to serialize.
+     * @return JSON string representation of the entry.
+     */
+    String toJson(const LogEntry& entry) const;
+
+    /// Worst-case size of one entry written by writeJson: every character escaped as \u00XX
+    static constexpr size_t EXPORT_JSON_SIZE = 6 * (TAG_SIZE + LOG_SIZE + FIELDS_SIZE) + 128;
+
+    /**
+     * @brief Write an entry as a JSON object without allocating.
+     * @param entry Entry to write.
+     * @param out Destination with room for EXPORT_JSON_SIZE bytes.
+     * @return Number of bytes written.
+     */
+    size_t writeJson(const LogEntry& entry, char* out) const;
+
+    /**
+     * @brief Write a JSON string with escaping.
+     * @param text Terminated text.
+     * @param out Destination with room for six bytes per character plus two.
+     * @return Number of bytes written.
+     */
+    static size_t writeJsonString(const char* text, char* out);
+
+    /**
+     * @brief Export entries to a stream or a buffer.
+     * @param reader Reader whose cursor is advanced.
+     * @param maxEntries Maximum number of entries to export.
+     * @param format JSON array or newline-delimited objects.
+     * @param out Destination stream, or nullptr to write into buffer.
+     * @param buffer Destination buffer when out is nullptr.
+     * @param size Size of buffer.
+     * @param length Set to the number of bytes written.
+     * @return Number of entries exported.
+     */
+    size_t exportEntries(ReaderId reader, size_t maxEntries, ExportFormat format, Print* out,
+                         char* buffer, size_t size, size_t& length);
+
+    /**
+     * @brief Run the callback, observers, sinks and serial output for a batch of entries.
+     * @param entries Pointer to the first entry.
+     * @param count Number of entries.
+     */
+    void dispatch(const LogEntry* entries, size_t count);
+
+    /**
+     * @brief Apply duplicate suppression and rate limiting to a record about to be logged.
+     *
+     * Logs the pending repeat summary of the tag when the record ends a run of repeats.
+     * @param tag Registry id of the tag.
+     * @param level Severity level of the record.
+     * @param text Format string, or the message of an unformatted record.
+     * @param hashText Compare by text contents instead of by pointer.
+     * @return true if the record should be stored.
+     */
+    bool admit(TagId tag, Level level, const char* text, bool hashText);
+
+    /**
+     * @brief Log the repeat summaries whose repeatWindow has passed, if any are due.
+     *
+     * Called on the read, export and dispatcher paths so a run of repeats
+     * is reported even when its tag logs nothing afterwards.
+     */
+    void flushRepeats();
+
+    /**
+     * @brief Refill a tag's rate limit budget and take one record from it.
+     * @param state Suppression state of the tag, with suppressionLock held.
+     * @param config Active suppression settings.
+     * @param now Current time in us.
+     * @return true if the budget allowed the record.
+     */
+    static bool takeToken(TagSuppression& state, const SuppressionConfig& config, int64_t now);
+
+    /**
+     * @brief Log every pending repeat summary whose repeatWindow has passed.
+     * @param now Current time in us.
+     */
+    void sweepRepeats(int64_t now);
+
+    /**
+     * @brief Log "Previous message repeated N times" for a tag.
+     * @param tag Registry id of the tag.
+     * @param level Level of the repeated record.
+     * @param repeats Number of repeats.
+     */
+    void logRepeats(TagId tag, Level level, uint32_t repeats);
+
+    /**
+     * @brief Store an unformatted message in a record, truncating it if needed.
+     * @param record Record to fill.
+     * @param message Content of the log message.
+     */
+    static void setMessage(Record& record, const char* message);
+
+    /**
+     * @brief Append OVERFLOW_MSG to a message, overwriting its end if there is no room.
+     * @param message Buffer of LOG_SIZE bytes.
+     * @param length Length of the message in the buffer.
+     * @return Length of the marked message.
+     */
+    static size_t markOverflow(char* message, size_t length);
+
+    /**
+     * @brief Get the text shown by text outputs: the message followed by any fields.
+     * @param entry Entry to describe.
+     * @param text Buffer of TEXT_SIZE bytes, used only when the entry has fields.
+     * @return The message, or text holding the message and fields.
+     */
+    static const char* describe(const LogEntry& entry, char* text);
+
+    static constexpr size_t TEXT_SIZE = LOG_SIZE + 6 * FIELDS_SIZE; ///< Room for a message and its rendered fields
 
     /**
      * @brief Add a log entry to the buffer.
-     * @param tag Tag for the log entry.
+     * @param tag Registry id of the tag.
      * @param level Severity level of the log.
      * @param message Content of the log message.
      */
-    void addLog(std::string_view tag, Level level, const char* message);
+    void addLog(TagId tag, Level level, const char* message);
 
-    Logger(); ///< Private constructor for singleton pattern
-    Logger(const Logger&) = delete; ///< Deleted copy constructor
-    Logger& operator=(const Logger&) = delete; ///< Deleted assignment operator
+    /**
+     * @brief Store a record in the buffer and deliver it to the sinks.
+     * @param tag Registry id of the tag.
+     * @param level Severity level of the log.
+     * @param record Record with its message or format fields populated.
+     */
+    void addRecord(TagId tag, Level level, Record& record);
 };
 
+#define LOGGER_TEMPLATE template<size_t Capacity, size_t MsgSize, size_t TagSize, typename Allocator>
+#define LOGGER_CLASS BasicLogger<Capacity, MsgSize, TagSize, Allocator>
+
+LOGGER_TEMPLATE
+LOGGER_CLASS& LOGGER_CLASS::instance() {
+    static BasicLogger instance;
+    return instance;
+}
+
+LOGGER_TEMPLATE
+LOGGER_CLASS::BasicLogger() {
+    uint32_t* words = WordTraits::allocate(wordAllocator, RING_COUNT * RING_WORDS);
+    memset(words, 0, RING_COUNT * RING_WORDS * WORD_SIZE);
+    for (size_t i = 0; i < RING_COUNT; ++i) {
+        rings[i].words = words + i * RING_WORDS;
+    }
+    for (auto& tagLevel : tagLevels) {
+        tagLevel.store(INHERIT_LEVEL, std::memory_order_relaxed);
+    }
+    registerTag(DEFAULT_TAG);
+    readers[DEFAULT_READER].active = true;
+}
+
+LOGGER_TEMPLATE
+LOGGER_CLASS::~BasicLogger() {
+    stopDispatcher();
+    WordTraits::deallocate(wordAllocator, rings[0].words, RING_COUNT * RING_WORDS);
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::addSink(Sink& sink) {
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    sinks.push_back(&sink);
+    sinksAttached.store(true);
+}
+
+LOGGER_TEMPLATE
+typename LOGGER_CLASS::TagId LOGGER_CLASS::registerTag(std::string_view name) {
+    name = name.substr(0, TAG_SIZE - 1);
+
+    // Registered names never change, so the lookup needs no lock
+    size_t count = tagCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        if (name.compare(tagNames[i]) == 0) {
+            return static_cast<TagId>(i);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(tagMutex);
+    size_t registered = tagCount.load(std::memory_order_relaxed);
+    for (size_t i = count; i < registered; ++i) {
+        if (name.compare(tagNames[i]) == 0) {
+            return static_cast<TagId>(i);
+        }
+    }
+    if (registered == MAX_TAGS) {
+        return DEFAULT_TAG_ID;
+    }
+
+    memcpy(tagNames[registered], name.data(), name.length());
+    tagNames[registered][name.length()] = '\0';
+    tagCount.store(registered + 1, std::memory_order_release);
+    return static_cast<TagId>(registered);
+}
+
+LOGGER_TEMPLATE
+const char* LOGGER_CLASS::getTagName(TagId id) const {
+    return id < tagCount.load(std::memory_order_acquire) ? tagNames[id] : DEFAULT_TAG.data();
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::setTagLevel(std::string_view tag, Level level) {
+    tagLevels[registerTag(tag)].store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::clearTagLevel(std::string_view tag) {
+    tagLevels[registerTag(tag)].store(INHERIT_LEVEL, std::memory_order_relaxed);
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::applyLevelCommand(std::string_view command) {
+    bool valid = true;
+    while (!command.empty()) {
+        size_t end = std::min(command.find(','), command.length());
+        std::string_view assignment = command.substr(0, end);
+        command.remove_prefix(std::min(end + 1, command.length()));
+
+        size_t separator = assignment.find('=');
+        if (separator == std::string_view::npos || separator == 0) {
+            valid = false;
+            continue;
+        }
+        std::string_view tag = assignment.substr(0, separator);
+        std::string_view name = assignment.substr(separator + 1);
+
+        Level level;
+        if (name.empty() && tag != "*") {
+            clearTagLevel(tag);
+        } else if (!parseLevel(name, level)) {
+            valid = false;
+        } else if (tag == "*") {
+            setFilterLevel(level);
+        } else {
+            setTagLevel(tag, level);
+        }
+    }
+    return valid;
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::enableSuppression(const SuppressionConfig& config) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&suppressionLock);
+    suppressionConfig = config;
+    for (TagSuppression& state : suppression) {
+        state = TagSuppression();
+        state.tokens = config.burst * 1000;
+        state.lastRefill = now;
+    }
+    repeatFlushAt = INT64_MAX;
+    portEXIT_CRITICAL(&suppressionLock);
+    suppressionActive.store(true);
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::disableSuppression() {
+    suppressionActive.store(false);
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::admit(TagId tag, Level level, const char* text, bool hashText) {
+    if (!suppressionActive.load(std::memory_order_relaxed)) {
+        return true;
+    }
+
+    uint32_t key;
+    if (hashText) {
+        // FNV-1a, so unformatted messages built in reused buffers are not mistaken for repeats
+        key = 2166136261u;
+        for (const char* c = text; *c != '\0'; ++c) {
+            key = (key ^ static_cast<uint8_t>(*c)) * 16777619u;
+        }
+    } else {
+        key = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(text));
+    }
+
+    int64_t now = esp_timer_get_time();
+    uint32_t repeats = 0;
+    Level repeatLevel = level;
+    bool stored = true;
+
+    portENTER_CRITICAL(&suppressionLock);
+    TagSuppression& state = suppression[tag];
+    const SuppressionConfig& config = suppressionConfig;
+    const int64_t window = static_cast<int64_t>(config.repeatWindow) * 1000;
+    const bool flushDue = now >= repeatFlushAt;
+
+    if (config.collapseRepeats && state.hasLast && state.lastKey == key && now - state.windowStart < window) {
+        if (state.repeats++ == 0) {
+            repeatFlushAt = std::min(repeatFlushAt, state.windowStart + window);
+        }
+        repeatSuppressed.fetch_add(1, std::memory_order_relaxed);
+        stored = false;
+    } else if (config.burst > 0 && !takeToken(state, config, now)) {
+        rateLimited.fetch_add(1, std::memory_order_relaxed);
+        stored = false;
+    } else if (config.collapseRepeats) {
+        repeats = state.repeats;
+        repeatLevel = state.lastLevel;
+        state.hasLast = true;
+        state.lastKey = key;
+        state.lastLevel = level;
+        state.repeats = 0;
+        state.windowStart = now;
+    }
+    portEXIT_CRITICAL(&suppressionLock);
+
+    // Other tags' overdue counts go first, so summaries stay ahead of newer records
+    if (flushDue) {
+        sweepRepeats(now);
+    }
+    if (repeats > 0) {
+        logRepeats(tag, repeatLevel, repeats);
+    }
+    return stored;
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::takeToken(TagSuppression& state, const SuppressionConfig& config, int64_t now) {
+    uint64_t refill = static_cast<uint64_t>(now - state.lastRefill) * config.ratePerSecond / 1000;
+    state.tokens = static_cast<uint32_t>(std::min<uint64_t>(state.tokens + refill, config.burst * 1000));
+    state.lastRefill = now;
+    if (state.tokens < 1000) {
+        return false;
+    }
+    state.tokens -= 1000;
+    return true;
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::flushRepeats() {
+    if (!suppressionActive.load(std::memory_order_relaxed)) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&suppressionLock);
+    const bool flushDue = now >= repeatFlushAt;
+    portEXIT_CRITICAL(&suppressionLock);
+    if (flushDue) {
+        sweepRepeats(now);
+    }
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::sweepRepeats(int64_t now) {
+    // Tags whose first repeat arrives during the sweep lower the deadline again themselves
+    portENTER_CRITICAL(&suppressionLock);
+    repeatFlushAt = INT64_MAX;
+    portEXIT_CRITICAL(&suppressionLock);
+
+    const size_t count = tagCount.load(std::memory_order_acquire);
+    for (size_t tag = 0; tag < count; ++tag) {
+        uint32_t repeats = 0;
+        Level level = Level::DEBUG;
+        portENTER_CRITICAL(&suppressionLock);
+        TagSuppression& state = suppression[tag];
+        if (state.repeats > 0) {
+            int64_t due = state.windowStart + static_cast<int64_t>(suppressionConfig.repeatWindow) * 1000;
+            if (now >= due) {
+                repeats = state.repeats;
+                level = state.lastLevel;
+                state.repeats = 0;
+            } else {
+                repeatFlushAt = std::min(repeatFlushAt, due);
+            }
+        }
+        portEXIT_CRITICAL(&suppressionLock);
+
+        if (repeats > 0) {
+            logRepeats(static_cast<TagId>(tag), level, repeats);
+        }
+    }
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::logRepeats(TagId tag, Level level, uint32_t repeats) {
+    char summary[48];
+    snprintf(summary, sizeof(summary), "Previous message repeated %u times", static_cast<unsigned>(repeats));
+    addLog(tag, level, summary);
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::getDroppedCount() const {
+    return getLostCount(DEFAULT_READER);
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::getNextLog(LogEntry& entry) {
+    return readLog(DEFAULT_READER, entry);
+}
+
+LOGGER_TEMPLATE
+String LOGGER_CLASS::getNextLogJson() {
+    LogEntry entry;
+    if (getNextLog(entry)) {
+        return toJson(entry);
+    }
+    return String(""); // Empty string if no more logs
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::peekNextLog(LogEntry& entry, size_t offset) {
+    return peekLog(DEFAULT_READER, entry, offset);
+}
+
+LOGGER_TEMPLATE
+String LOGGER_CLASS::peekNextLogJson(size_t offset) {
+    LogEntry entry;
+    if (peekNextLog(entry, offset)) {
+        return toJson(entry);
+    }
+    return String(""); // Empty string if no more logs
+}
+
+LOGGER_TEMPLATE
+String LOGGER_CLASS::toJson(const LogEntry& entry) const {
+    JsonDocument doc;
+    doc["tag"] = entry.tag;
+    doc["level"] = static_cast<int>(entry.level);
+    doc["timestamp_us"] = entry.timestamp;
+    int64_t epochTime = toEpochTime(entry.timestamp);
+    if (epochTime != 0) {
+        doc["epoch_ms"] = epochTime / 1000;
+    }
+    doc["message"] = entry.message;
+
+    if (entry.fieldsLength > 0) {
+        JsonObject fields = doc["fields"].to<JsonObject>();
+        LogFormat::FieldReader reader(entry.fields, entry.fieldsLength);
+        LogFormat::FieldValue field;
+        while (reader.next(field)) {
+            switch (field.type) {
+                case LogFormat::ArgType::INT32:
+                case LogFormat::ArgType::INT64: fields[field.key] = static_cast<int64_t>(field.bits); break;
+                case LogFormat::ArgType::UINT32:
+                case LogFormat::ArgType::UINT64:
+                case LogFormat::ArgType::POINTER: fields[field.key] = field.bits; break;
+                case LogFormat::ArgType::DOUBLE: fields[field.key] = field.real; break;
+                case LogFormat::ArgType::STRING: fields[field.key] = field.text; break;
+            }
+        }
+    }
+
+    String jsonString;
+    serializeJson(doc, jsonString);
+    return jsonString;
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::writeJsonString(const char* text, char* out) {
+    static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+    char* p = out;
+    *p++ = '"';
+    for (const char* c = text; *c != '\0'; ++c) {
+        uint8_t byte = static_cast<uint8_t>(*c);
+        if (byte == '"' || byte == '\\') {
+            *p++ = '\\';
+            *p++ = static_cast<char>(byte);
+        } else if (byte == '\n') {
+            *p++ = '\\';
+            *p++ = 'n';
+        } else if (byte == '\r') {
+            *p++ = '\\';
+            *p++ = 'r';
+        } else if (byte == '\t') {
+            *p++ = '\\';
+            *p++ = 't';
+        } else if (byte < 0x20) {
+            memcpy(p, "\\u00", 4);
+            p[4] = HEX_DIGITS[byte >> 4];
+            p[5] = HEX_DIGITS[byte & 0x0F];
+            p += 6;
+        } else {
+            *p++ = static_cast<char>(byte);
+        }
+    }
+    *p++ = '"';
+    return p - out;
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::writeJson(const LogEntry& entry, char* out) const {
+    // Same fields and order as toJson
+    char* p = out;
+    memcpy(p, "{\"tag\":", 7);
+    p += 7;
+    p += writeJsonString(entry.tag, p);
+    p += sprintf(p, ",\"level\":%d,\"timestamp_us\":%lld", static_cast<int>(entry.level),
+                 static_cast<long long>(entry.timestamp));
+    int64_t epochTime = toEpochTime(entry.timestamp);
+    if (epochTime != 0) {
+        p += sprintf(p, ",\"epoch_ms\":%lld", static_cast<long long>(epochTime / 1000));
+    }
+    memcpy(p, ",\"message\":", 11);
+    p += 11;
+    p += writeJsonString(entry.message, p);
+
+    if (entry.fieldsLength > 0) {
+        memcpy(p, ",\"fields\":{", 11);
+        p += 11;
+        LogFormat::FieldReader reader(entry.fields, entry.fieldsLength);
+        LogFormat::FieldValue field;
+        bool first = true;
+        while (reader.next(field)) {
+            if (!first) {
+                *p++ = ',';
+            }
+            first = false;
+            p += writeJsonString(field.key, p);
+            *p++ = ':';
+            switch (field.type) {
+                case LogFormat::ArgType::INT32:
+                case LogFormat::ArgType::INT64:
+                    p += sprintf(p, "%lld", static_cast<long long>(field.bits));
+                    break;
+                case LogFormat::ArgType::UINT32:
+                case LogFormat::ArgType::UINT64:
+                case LogFormat::ArgType::POINTER:
+                    p += sprintf(p, "%llu", static_cast<unsigned long long>(field.bits));
+                    break;
+                case LogFormat::ArgType::DOUBLE:
+                    // JSON has no NaN or infinity
+                    p += std::isfinite(field.real) ? sprintf(p, "%.15g", field.real) : sprintf(p, "null");
+                    break;
+                case LogFormat::ArgType::STRING:
+                    p += writeJsonString(field.text, p);
+                    break;
+            }
+        }
+        *p++ = '}';
+    }
+    *p++ = '}';
+    return p - out;
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::exportLogs(Print& out, size_t maxEntries, ExportFormat format, ReaderId reader) {
+    size_t length;
+    return exportEntries(reader, maxEntries, format, &out, nullptr, 0, length);
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::exportLogs(char* buffer, size_t size, size_t& length, size_t maxEntries,
+                                ExportFormat format, ReaderId reader) {
+    return exportEntries(reader, maxEntries, format, nullptr, buffer, size, length);
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::exportEntries(ReaderId reader, size_t maxEntries, ExportFormat format, Print* out,
+                                   char* buffer, size_t size, size_t& length) {
+    flushRepeats();
+    const bool array = format == ExportFormat::JSON_ARRAY;
+    const size_t closing = array ? 1 : 0;
+    length = 0;
+    if (out == nullptr && size < 2 * closing + 1) {
+        if (size > 0) {
+            buffer[0] = '\0';
+        }
+        return 0;
+    }
+
+    auto emit = [&](const char* text, size_t count) {
+        if (out != nullptr) {
+            out->write(reinterpret_cast<const uint8_t*>(text), count);
+        } else {
+            memcpy(buffer + length, text, count);
+        }
+        length += count;
+    };
+
+    if (array) {
+        emit("[", 1);
+    }
+
+    size_t exported = 0;
+    if (reader < MAX_READERS) {
+        Reader& state = readers[reader];
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.active) {
+            Record record;
+            LogEntry entry;
+            char line[EXPORT_JSON_SIZE + 2]; // Entry with its separator or newline
+            size_t skipped = 0;
+
+            while (exported < maxEntries) {
+                // Advance a copy so an entry that does not fit the buffer stays unread
+                Cursor next = state.cursor;
+                size_t nextSkipped = skipped;
+                if (!readNext(next, record, nextSkipped)) {
+                    break;
+                }
+                materialize(record, entry);
+
+                size_t lineLength = 0;
+                if (array && exported > 0) {
+                    line[lineLength++] = ',';
+                }
+                lineLength += writeJson(entry, line + lineLength);
+                if (!array) {
+                    line[lineLength++] = '\n';
+                }
+
+                if (out == nullptr && length + lineLength + closing + 1 > size) {
+                    break;
+                }
+                emit(line, lineLength);
+                state.cursor = next;
+                skipped = nextSkipped;
+                ++exported;
+            }
+            state.lost.fetch_add(skipped, std::memory_order_relaxed);
+        }
+    }
+
+    if (array) {
+        emit("]", 1);
+    }
+    if (out == nullptr) {
+        buffer[length] = '\0';
+    }
+    return exported;
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::exportBinary(LogWire::Encoder& encoder, uint8_t* buffer, size_t size, size_t& length,
+                                  size_t maxEntries, ReaderId reader) {
+    flushRepeats();
+    length = 0;
+    if (reader >= MAX_READERS) {
+        return 0;
+    }
+    Reader& state = readers[reader];
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.active) {
+        return 0;
+    }
+
+    Record record;
+    size_t exported = 0;
+    size_t skipped = 0;
+    while (exported < maxEntries) {
+        // Advance a copy so an entry that does not fit the buffer stays unread
+        Cursor next = state.cursor;
+        size_t nextSkipped = skipped;
+        if (!readNext(next, record, nextSkipped)) {
+            break;
+        }
+
+        LogWire::Entry wire = {};
+        wire.sequence = next.sequence() - 1;
+        wire.timestamp = record.timestamp;
+        wire.level = static_cast<uint8_t>(record.level);
+        wire.tag = record.tag;
+        wire.tagName = getTagName(record.tag);
+#ifdef LOGGER_DEFERRED_FORMAT
+        if (record.format == nullptr) {
+            wire.message = reinterpret_cast<const char*>(record.args);
+            wire.messageLength = record.argsLength;
+        } else {
+            wire.format = record.format;
+            wire.args = record.args;
+            wire.argsLength = record.argsLength;
+        }
+#else
+        wire.message = record.message;
+        wire.messageLength = strlen(record.message);
+#endif
+
+        size_t written = encoder.encode(wire, buffer + length, size - length);
+        if (written == 0) {
+            break;
+        }
+        ++exported;
+        state.cursor = next;
+        skipped = nextSkipped;
+        length += written;
+    }
+    state.lost.fetch_add(skipped, std::memory_order_relaxed);
+    return exported;
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::getValidLogCount() const {
+    return getPendingCount(DEFAULT_READER);
+}
+
+LOGGER_TEMPLATE
+typename LOGGER_CLASS::ReaderId LOGGER_CLASS::addReader(bool fromOldest) {
+    std::lock_guard<std::mutex> registration(readerMutex);
+    for (size_t i = 0; i < MAX_READERS; ++i) {
+        Reader& reader = readers[i];
+        std::lock_guard<std::mutex> lock(reader.mutex);
+        if (!reader.active) {
+            reader.cursor = fromOldest ? oldestCursor() : writeCursor();
+            reader.lost.store(0, std::memory_order_relaxed);
+            reader.active = true;
+            return static_cast<ReaderId>(i);
+        }
+    }
+    return INVALID_READER;
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::removeReader(ReaderId reader) {
+    if (reader == DEFAULT_READER || reader >= MAX_READERS) {
+        return;
+    }
+    std::lock_guard<std::mutex> registration(readerMutex);
+    std::lock_guard<std::mutex> lock(readers[reader].mutex);
+    readers[reader].active = false;
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::readLog(ReaderId reader, LogEntry& entry) {
+    if (reader >= MAX_READERS) {
+        return false;
+    }
+    flushRepeats();
+    Reader& state = readers[reader];
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.active) {
+        return false;
+    }
+    size_t skipped = 0;
+    bool found = readNextEntry(state.cursor, entry, skipped);
+    state.lost.fetch_add(skipped, std::memory_order_relaxed);
+    return found;
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::peekLog(ReaderId reader, LogEntry& entry, size_t offset) {
+    if (reader >= MAX_READERS) {
+        return false;
+    }
+    flushRepeats();
+    Reader& state = readers[reader];
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.active) {
+        return false;
+    }
+
+    // Records have different sizes, so walk a copy of the cursor to the offset
+    Cursor cursor = state.cursor;
+    Record record;
+    size_t skipped = 0;
+    for (size_t i = 0; i <= offset; ++i) {
+        if (!readNext(cursor, record, skipped)) {
+            return false;
+        }
+    }
+    materialize(record, entry);
+    return true;
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::getPendingCount(ReaderId reader) const {
+    if (reader >= MAX_READERS) {
+        return 0;
+    }
+    const Reader& state = readers[reader];
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.active) {
+        return 0;
+    }
+    size_t unread = 0;
+    for (size_t i = 0; i < RING_COUNT; ++i) {
+        uint32_t oldest = oldestIn(rings[i]).sequence;
+        uint32_t next;
+        frontierOf(rings[i], next);
+        // Sequence numbers wrap, so compare distances from the write side
+        unread += std::min(next - state.cursor.rings[i].sequence, next - oldest);
+    }
+    return unread;
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::getLostCount(ReaderId reader) const {
+    return reader < MAX_READERS ? readers[reader].lost.load(std::memory_order_relaxed) : 0;
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::getLogCount() const {
+    size_t count = 0;
+    for (const Ring& ring : rings) {
+        count += ring.nextSequence.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::dispatchBacklogFull() const {
+    // Room left for producers before the next record may evict one the dispatcher has not read
+    const Ring& ring = rings[currentRing()];
+    return wordsBetween(ring.dispatchPosition.load(std::memory_order_acquire), ring.head.load(std::memory_order_relaxed)) >=
+           RING_WORDS - MAX_RECORD_WORDS;
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::prepareDispatch(size_t batchSize) {
+    dispatchBatch.resize(batchSize);
+    dispatchCursor = writeCursor();
+    for (size_t i = 0; i < RING_COUNT; ++i) {
+        rings[i].dispatchPosition.store(dispatchCursor.rings[i].position);
+    }
+}
+
+LOGGER_TEMPLATE
+uint32_t LOGGER_CLASS::frontierOf(const Ring& ring, uint32_t& sequence) {
+    while (true) {
+        sequence = ring.nextSequence.load(std::memory_order_acquire);
+        uint32_t position = ring.frontier[sequence & 1].load(std::memory_order_relaxed);
+        // Once the number moves on, this slot is rewritten for the number after that
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (ring.nextSequence.load(std::memory_order_relaxed) == sequence) {
+            return position;
+        }
+    }
+}
+
+LOGGER_TEMPLATE
+typename LOGGER_CLASS::RingCursor LOGGER_CLASS::oldestIn(const Ring& ring) {
+    while (true) {
+        RingCursor cursor;
+        cursor.position = ring.start.load(std::memory_order_acquire);
+        if (frontierOf(ring, cursor.sequence) == cursor.position) {
+            return cursor;
+        }
+        // The oldest record is numbered; its number holds unless it is evicted while being read
+        uint32_t sequence = ring.words[wordIndex(advance(cursor.position, 1))];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (ring.start.load(std::memory_order_relaxed) == cursor.position) {
+            cursor.sequence = sequence;
+            return cursor;
+        }
+    }
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::numberRecords(Ring& ring) {
+    while (true) {
+        uint32_t sequence;
+        uint32_t position = frontierOf(ring, sequence);
+        std::atomic<uint32_t>& flags = ring.committed[wordIndex(position) / 32];
+        const uint32_t flag = uint32_t{1} << (wordIndex(position) % 32);
+        // A clear flag means the record is still being written, or another producer is numbering it
+        if ((flags.fetch_and(~flag) & flag) == 0) {
+            return;
+        }
+        if (ring.nextSequence.load() != sequence) {
+            // The frontier moved on meanwhile, so the flag belonged to a later record at the same index
+            flags.fetch_or(flag);
+            continue;
+        }
+
+        uint32_t words = ring.words[wordIndex(position)];
+        ring.words[wordIndex(advance(position, 1))] = sequence;
+        // Pairs with frontierOf: a reader that sees the slot written below also sees the number it replaces
+        std::atomic_thread_fence(std::memory_order_release);
+        ring.frontier[(sequence + 1) & 1].store(advance(position, words), std::memory_order_relaxed);
+        // Sequentially consistent, like the flag updates, so a producer committing at the new frontier
+        // either sees it or has its flag seen by the next pass of this loop
+        ring.nextSequence.store(sequence + 1);
+    }
+}
+
+LOGGER_TEMPLATE
+typename LOGGER_CLASS::Cursor LOGGER_CLASS::oldestCursor() {
+    Cursor cursor;
+    for (size_t i = 0; i < RING_COUNT; ++i) {
+        cursor.rings[i] = oldestIn(rings[i]);
+    }
+    return cursor;
+}
+
+LOGGER_TEMPLATE
+typename LOGGER_CLASS::Cursor LOGGER_CLASS::writeCursor() {
+    Cursor cursor;
+    for (size_t i = 0; i < RING_COUNT; ++i) {
+        cursor.rings[i].position = frontierOf(rings[i], cursor.rings[i].sequence);
+    }
+    return cursor;
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::encode(const Record& record, uint32_t* words) {
+    RecordHeader header = {};
+    header.level = static_cast<uint8_t>(record.level);
+    header.tag = record.tag;
+
+    uint8_t* body = reinterpret_cast<uint8_t*>(words + HEADER_WORDS);
+    size_t fieldsBytes = 0;
+    if (record.fieldsLength > 0) {
+        header.level |= FIELDS_FLAG;
+        body[0] = record.fieldsLength;
+        memcpy(body + 1, record.fields, record.fieldsLength);
+        fieldsBytes = 1 + record.fieldsLength;
+        body += fieldsBytes;
+    }
+#ifdef LOGGER_DEFERRED_FORMAT
+    if (record.truncated) {
+        header.level |= TRUNCATED_FLAG;
+    }
+    memcpy(body, &record.format, sizeof(record.format));
+    memcpy(body + sizeof(record.format), record.args, record.argsLength);
+    header.bodyLength = static_cast<uint16_t>(fieldsBytes + sizeof(record.format) + record.argsLength);
+#else
+    size_t messageLength = strnlen(record.message, LOG_SIZE - 1);
+    memcpy(body, record.message, messageLength);
+    header.bodyLength = static_cast<uint16_t>(fieldsBytes + messageLength);
+#endif
+
+    memcpy(words + 1, &header, sizeof(header));
+    words[0] = static_cast<uint32_t>(HEADER_WORDS + (header.bodyLength + WORD_SIZE - 1) / WORD_SIZE);
+    return words[0];
+}
+
+LOGGER_TEMPLATE
+uint32_t LOGGER_CLASS::decode(const uint32_t* words, Record& record) {
+    RecordHeader header;
+    memcpy(&header, words + 1, sizeof(header));
+    record.level = static_cast<Level>(header.level & ~(FIELDS_FLAG | TRUNCATED_FLAG));
+    record.tag = header.tag;
+    record.timestamp = header.timestamp;
+
+    const uint8_t* body = reinterpret_cast<const uint8_t*>(words + HEADER_WORDS);
+    size_t bodyLength = header.bodyLength;
+    record.fieldsLength = 0;
+    if (header.level & FIELDS_FLAG) {
+        record.fieldsLength = body[0];
+        memcpy(record.fields, body + 1, record.fieldsLength);
+        body += 1 + record.fieldsLength;
+        bodyLength -= 1 + record.fieldsLength;
+    }
+#ifdef LOGGER_DEFERRED_FORMAT
+    memcpy(&record.format, body, sizeof(record.format));
+    record.truncated = (header.level & TRUNCATED_FLAG) != 0;
+    record.argsLength = static_cast<uint16_t>(bodyLength - sizeof(record.format));
+    memcpy(record.args, body + sizeof(record.format), record.argsLength);
+#else
+    memcpy(record.message, body, bodyLength);
+    record.message[bodyLength] = '\0';
+#endif
+    return header.sequence;
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::copyIn(Ring& ring, uint32_t position, const uint32_t* words, size_t count) {
+    size_t index = wordIndex(position);
+    size_t first = std::min(count, RING_WORDS - index);
+    memcpy(ring.words + index, words, first * WORD_SIZE);
+    memcpy(ring.words, words + first, (count - first) * WORD_SIZE);
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::copyOut(const Ring& ring, uint32_t position, uint32_t* words, size_t count) {
+    size_t index = wordIndex(position);
+    size_t first = std::min(count, RING_WORDS - index);
+    memcpy(words, ring.words + index, first * WORD_SIZE);
+    memcpy(words + first, ring.words, (count - first) * WORD_SIZE);
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::publish(Record& record) {
+    uint32_t words[MAX_RECORD_WORDS];
+    size_t count = encode(record, words);
+
+    // A task moved to the other core in between still writes a consistent ring, it only shares it
+    Ring& ring = rings[currentRing()];
+    uint32_t position;
+    bool reserved = false;
+    while (!reserved) {
+        // Load start first: head is never behind it, so the distance below cannot underflow
+        uint32_t oldest = ring.start.load(std::memory_order_acquire);
+        position = ring.head.load(std::memory_order_relaxed);
+        if (wordsBetween(oldest, position) + count <= RING_WORDS) {
+            reserved = ring.head.compare_exchange_weak(position, advance(position, count), std::memory_order_acq_rel,
+                                                       std::memory_order_relaxed);
+            continue;
+        }
+
+        // Evict the oldest record, but only once it is numbered: an unnumbered one may still be written
+        uint32_t sequence;
+        if (frontierOf(ring, sequence) == oldest) {
+            break;
+        }
+        // A stale start fails the swap, whatever size was read for it
+        uint32_t words = ring.words[wordIndex(oldest)];
+        ring.start.compare_exchange_weak(oldest, advance(oldest, words), std::memory_order_acq_rel,
+                                         std::memory_order_relaxed);
+    }
+
+    // Stamped after the reservation, so timestamps follow sequence order unless producers race
+    int64_t timestamp = esp_timer_get_time();
+    record.timestamp = timestamp;
+    if (!reserved) {
+        busyDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint8_t* header = reinterpret_cast<uint8_t*>(&words[1]);
+    memcpy(header + offsetof(RecordHeader, timestamp), &timestamp, sizeof(timestamp));
+
+    // Readers that copy any of the words written below see the start that freed them and discard their copy
+    std::atomic_thread_fence(std::memory_order_release);
+    copyIn(ring, position, words, count);
+    ring.committed[wordIndex(position) / 32].fetch_or(uint32_t{1} << (wordIndex(position) % 32));
+    numberRecords(ring);
+}
+
+LOGGER_TEMPLATE
+typename LOGGER_CLASS::ReadStatus LOGGER_CLASS::readRecord(const Ring& ring, uint32_t position, Record& record,
+                                                           size_t& words, uint32_t& sequence) {
+    uint32_t copy[MAX_RECORD_WORDS];
+    words = ring.words[wordIndex(position)];
+    bool plausible = words >= HEADER_WORDS && words <= MAX_RECORD_WORDS;
+    if (plausible) {
+        copyOut(ring, position, copy, words);
+    }
+
+    // Seqlock validation: the copy is only valid if no producer reclaimed its space meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (wordsBetween(ring.start.load(std::memory_order_relaxed), position) > RING_WORDS || !plausible) {
+        return ReadStatus::OVERWRITTEN;
+    }
+
+    sequence = decode(copy, record);
+    return ReadStatus::READY;
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::readRing(const Ring& ring, RingCursor& cursor, Record& record, size_t& skipped) {
+    while (true) {
+        uint32_t oldest = ring.start.load(std::memory_order_acquire);
+        if (wordsBetween(oldest, cursor.position) > RING_WORDS) {
+            cursor.position = oldest;
+        }
+        uint32_t sequence;
+        if (cursor.position == frontierOf(ring, sequence)) {
+            return false;
+        }
+
+        size_t words;
+        if (readRecord(ring, cursor.position, record, words, sequence) == ReadStatus::READY) {
+            skipped += sequence - cursor.sequence;
+            cursor.position = advance(cursor.position, words);
+            cursor.sequence = sequence + 1;
+            return true;
+        }
+        // Overwritten while copying: continue from the new oldest record, the gap shows in its sequence number
+    }
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::peekTimestamp(const Ring& ring, RingCursor& cursor, int64_t& timestamp) {
+    while (true) {
+        uint32_t oldest = ring.start.load(std::memory_order_acquire);
+        if (wordsBetween(oldest, cursor.position) > RING_WORDS) {
+            cursor.position = oldest;
+        }
+        uint32_t sequence;
+        if (cursor.position == frontierOf(ring, sequence)) {
+            return false;
+        }
+
+        uint32_t header[HEADER_WORDS];
+        copyOut(ring, cursor.position, header, HEADER_WORDS);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (wordsBetween(ring.start.load(std::memory_order_relaxed), cursor.position) <= RING_WORDS) {
+            memcpy(&timestamp, reinterpret_cast<const uint8_t*>(&header[1]) + offsetof(RecordHeader, timestamp),
+                   sizeof(timestamp));
+            return true;
+        }
+    }
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::readNext(Cursor& cursor, Record& record, size_t& skipped) const {
+    if constexpr (RING_COUNT == 1) {
+        return readRing(rings[0], cursor.rings[0], record, skipped);
+    } else {
+        // Merge by timestamp; ties go to the lower ring so the order is stable
+        size_t next = RING_COUNT;
+        int64_t nextTimestamp = 0;
+        for (size_t i = 0; i < RING_COUNT; ++i) {
+            int64_t timestamp;
+            if (peekTimestamp(rings[i], cursor.rings[i], timestamp) && (next == RING_COUNT || timestamp < nextTimestamp)) {
+                next = i;
+                nextTimestamp = timestamp;
+            }
+        }
+        return next < RING_COUNT && readRing(rings[next], cursor.rings[next], record, skipped);
+    }
+}
+
+LOGGER_TEMPLATE
+bool LOGGER_CLASS::readNextEntry(Cursor& cursor, LogEntry& entry, size_t& skipped) const {
+    Record record;
+    if (!readNext(cursor, record, skipped)) {
+        return false;
+    }
+    materialize(record, entry);
+    return true;
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::materialize(const Record& record, LogEntry& entry) const {
+    strcpy(entry.tag, getTagName(record.tag));
+    entry.level = record.level;
+    entry.timestamp = record.timestamp;
+    entry.fieldsLength = record.fieldsLength;
+    memcpy(entry.fields, record.fields, record.fieldsLength);
+#ifdef LOGGER_DEFERRED_FORMAT
+    if (record.format == nullptr) {
+        memcpy(entry.message, record.args, record.argsLength);
+        entry.message[record.argsLength] = '\0';
+    } else {
+        size_t length = LogFormat::formatPacked(entry.message, LOG_SIZE, record.format, record.args, record.argsLength);
+        if (record.truncated) {
+            markOverflow(entry.message, length);
+        }
+    }
+#else
+    strcpy(entry.message, record.message);
+#endif
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::dispatch(const LogEntry* entries, size_t count) {
+    char text[TEXT_SIZE];
+    for (size_t i = 0; i < count; ++i) {
+        deliverText(entries[i].tag, entries[i].level, describe(entries[i], text));
+    }
+
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    for (Sink* sink : sinks) {
+        sink->write(entries, count);
+    }
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::drainToSinks(bool bounded) {
+    flushRepeats();
+    size_t delivered = 0;
+    const Cursor limit = bounded ? writeCursor() : Cursor();
+
+    while (!bounded || dispatchCursor.before(limit)) {
+        size_t skipped = 0;
+        size_t batched = 0;
+        while (batched < dispatchBatch.size() && (!bounded || dispatchCursor.before(limit)) &&
+               readNextEntry(dispatchCursor, dispatchBatch[batched], skipped)) {
+            ++batched;
+        }
+        if (skipped > 0) {
+            sinkDropped.fetch_add(skipped, std::memory_order_relaxed);
+        }
+        if (batched == 0) {
+            break;
+        }
+
+        dispatch(dispatchBatch.data(), batched);
+        publishDispatchPositions();
+        delivered += batched;
+    }
+
+    publishDispatchPositions();
+    return delivered;
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::idleSinks() {
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    for (Sink* sink : sinks) {
+        sink->idle();
+    }
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::publishDispatchPositions() {
+    for (size_t i = 0; i < RING_COUNT; ++i) {
+        rings[i].dispatchPosition.store(dispatchCursor.rings[i].position, std::memory_order_release);
+    }
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::setMessage(Record& record, const char* message) {
+#ifdef LOGGER_DEFERRED_FORMAT
+    // The text is stored as is, so it gets the same room as in immediate mode
+    record.format = nullptr;
+    char* text = reinterpret_cast<char*>(record.args);
+#else
+    char* text = record.message;
+#endif
+    // Copy message with potential overflow handling
+    size_t length = strlen(message);
+    if (length >= LOG_SIZE) {
+        // Message is too long, truncate and append overflow message
+        memcpy(text, message, LOG_SIZE - 1);
+        length = markOverflow(text, LOG_SIZE - 1);
+    } else {
+        // Message fits, copy as is
+        memcpy(text, message, length + 1);
+    }
+#ifdef LOGGER_DEFERRED_FORMAT
+    record.argsLength = static_cast<uint16_t>(length);
+#endif
+}
+
+LOGGER_TEMPLATE
+size_t LOGGER_CLASS::markOverflow(char* message, size_t length) {
+    size_t end = std::min(length, LOG_SIZE - OVERFLOW_MSG.length() - 1);
+    memcpy(message + end, OVERFLOW_MSG.data(), OVERFLOW_MSG.length());
+    message[end + OVERFLOW_MSG.length()] = '\0';
+    return end + OVERFLOW_MSG.length();
+}
+
+LOGGER_TEMPLATE
+const char* LOGGER_CLASS::describe(const LogEntry& entry, char* text) {
+    if (entry.fieldsLength == 0) {
+        return entry.message;
+    }
+    size_t length = strlen(entry.message);
+    memcpy(text, entry.message, length);
+    LogFormat::formatFields(text + length, TEXT_SIZE - length, entry.fields, entry.fieldsLength);
+    return text;
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::addLog(TagId tag, Level level, const char* message) {
+    if (isEnabled(tag, level)) {
+        Record record;
+        setMessage(record, message);
+        addRecord(tag, level, record);
+    }
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::addRecord(TagId tag, Level level, Record& record) {
+    record.tag = tag;
+    record.level = level;
+
+    TaskHandle_t dispatcher = dispatcherTask.load();
+    bool isDispatcher = dispatcher != nullptr && dispatcher == xTaskGetCurrentTaskHandle();
+    if (dispatcher != nullptr && !isDispatcher && dispatcherConfig.policy == OverflowPolicy::BLOCK) {
+        waitForDispatcher();
+    }
+
+    publish(record);
+
+    Mirror* mirrorTarget = mirror.load(std::memory_order_acquire);
+    // The task handle is only stored after the task is created, but the dispatcher owns every entry
+    // from its start cursor on, so entries logged in between must not be delivered here as well
+    bool deliverInline = dispatcher == nullptr && !dispatcherRunning.load() && hasInlineSinks();
+    if (mirrorTarget != nullptr || deliverInline) {
+        LogEntry entry;
+        materialize(record, entry);
+        if (mirrorTarget != nullptr) {
+            char text[TEXT_SIZE];
+            mirrorTarget->mirror(entry.tag, level, describe(entry, text));
+        }
+        if (deliverInline) {
+            dispatch(&entry, 1);
+        }
+    }
+    if (dispatcher != nullptr && !isDispatcher) {
+        notifyDispatcher(dispatcher);
+    }
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::log(std::string_view tag, Level level, const char* message) {
+    if (isCompiledIn(level)) {
+        log(Tag(tag), level, message);
+    }
+}
+
+LOGGER_TEMPLATE
+void LOGGER_CLASS::log(const Tag& tag, Level level, const char* message) {
+    if (isCompiledIn(level) && isEnabled(tag.id, level) && admit(tag.id, level, message, true)) {
+        addLog(tag.id, level, message);
+    }
+}
+
+#undef LOGGER_CLASS
+#undef LOGGER_TEMPLATE
+
+#ifdef LOGGER_USE_PSRAM
+using LoggerAllocator = PsramAllocator<uint8_t>; ///< Allocator of the Logger buffer
+#else
+using LoggerAllocator = std::allocator<uint8_t>; ///< Allocator of the Logger buffer
+#endif
+
+/**
+ * @typedef Logger
+ * @brief Logger layout used by the library, sized by the LOGGER_* build flags.
+ */
+using Logger = BasicLogger<LOGGER_CAPACITY, LOGGER_MESSAGE_SIZE, LOGGER_TAG_SIZE, LoggerAllocator>;
+
 /**
  * @typedef LogLevel
  * @brief Alias for Logger::Level for easier use.
  */
 using LogLevel = Logger::Level;
 
-#endif // ESP_LOGGER_H
\ No newline at end of file
+/**
+ * @def LOGGER_LOG
+ * @brief Log through the Logger instance unless the level is below LOGGER_MIN_LEVEL.
+ *
+ * The level must be a constant expression. When it is below the floor the
+ * call and its arguments are discarded at compile time. The tag is interned
+ * the first time the call site runs, so it must not change between calls.
+ */
+#define LOGGER_LOG(tag, level, ...) \
+    do { \
+        if constexpr (Logger::isCompiledIn(level)) { \
+            static const Logger::Tag loggerTag(tag); \
+            Logger::instance().log(loggerTag, level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+/**
+ * @def LOGGER_LOG_FIELDS
+ * @brief Log a message with key/value fields, filtered like LOGGER_LOG.
+ *
+ * Example: LOGGER_LOG_FIELDS("MQTT", Logger::Level::ERROR, "Connect failed",
+ * Logger::field("rc", rc), Logger::field("retry", retry));
+ */
+#define LOGGER_LOG_FIELDS(tag, level, message, ...) \
+    do { \
+        if constexpr (Logger::isCompiledIn(level)) { \
+            static const Logger::Tag loggerTag(tag); \
+            Logger::instance().logFields(loggerTag, level, message, __VA_ARGS__); \
+        } \
+    } while (0)
+
+/**
+ * @def LOGGER_FMT
+ * @brief Log with "{}" placeholders, filtered like LOGGER_LOG.
+ *
+ * The format must be a string literal; a placeholder count that differs
+ * from the number of arguments, or a stray brace, fails to compile.
+ * Example: LOGGER_FMT_INFO("WiFi", "Connected to {} as {}", ssid, WiFi.localIP());
+ */
+#define LOGGER_FMT(tag, level, format, ...) \
+    do { \
+        static_assert(BraceFormat::countPlaceholders(format) != BraceFormat::INVALID_FORMAT, \
+                      "Unmatched brace in log format, use {{ or }} for literal braces"); \
+        static_assert(BraceFormat::countPlaceholders(format) == decltype(BraceFormat::countArgs(__VA_ARGS__))::value, \
+                      "Log format placeholder count does not match the number of arguments"); \
+        if constexpr (Logger::isCompiledIn(level)) { \
+            static const Logger::Tag loggerTag(tag); \
+            Logger::instance().logFormat(loggerTag, level, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOGGER_DEBUG(tag, ...) LOGGER_LOG(tag, Logger::Level::DEBUG, __VA_ARGS__)     ///< Log at DEBUG level
+#define LOGGER_INFO(tag, ...) LOGGER_LOG(tag, Logger::Level::INFO, __VA_ARGS__)       ///< Log at INFO level
+#define LOGGER_WARNING(tag, ...) LOGGER_LOG(tag, Logger::Level::WARNING, __VA_ARGS__) ///< Log at WARNING level
+#define LOGGER_ERROR(tag, ...) LOGGER_LOG(tag, Logger::Level::ERROR, __VA_ARGS__)     ///< Log at ERROR level
+
+#define LOGGER_FMT_DEBUG(tag, ...) LOGGER_FMT(tag, Logger::Level::DEBUG, __VA_ARGS__)     ///< Log "{}" format at DEBUG level
+#define LOGGER_FMT_INFO(tag, ...) LOGGER_FMT(tag, Logger::Level::INFO, __VA_ARGS__)       ///< Log "{}" format at INFO level
+#define LOGGER_FMT_WARNING(tag, ...) LOGGER_FMT(tag, Logger::Level::WARNING, __VA_ARGS__) ///< Log "{}" format at WARNING level
+#define LOGGER_FMT_ERROR(tag, ...) LOGGER_FMT(tag, Logger::Level::ERROR, __VA_ARGS__)     ///< Log "{}" format at ERROR level
+
+#endif // ESP_LOGGER_H
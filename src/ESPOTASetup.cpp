@@ -20,8 +20,8 @@ void OTAManager::begin(const char* hostname, const char* password) {
     ArduinoOTA.onStart([this] {
         isOtaInProgress = true;
         String type = (ArduinoOTA.getCommand() == U_FLASH) ? "sketch" : "filesystem";
-        Logger::instance().log("OTAManager", Logger::Level::INFO, "Start updating %s", type.c_str());
-        Logger::instance().log("OTAManager", Logger::Level::INFO, "Free Heap: %d", ESP.getFreeHeap());
+        LOGGER_INFO("OTAManager", "Start updating %s", type.c_str());
+        LOGGER_INFO("OTAManager", "Free Heap: %d", ESP.getFreeHeap());
     });
 
     ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
@@ -29,30 +29,30 @@ void OTAManager::begin(const char* hostname, const char* password) {
         unsigned int percentage = (progress / (total / 100));
         
         if (percentage % 10 == 0 && percentage != lastPercentage) {
-            Logger::instance().log("OTAManager", Logger::Level::INFO, "OTA Progress: %u%%", percentage);
+            LOGGER_INFO("OTAManager", "OTA Progress: %u%%", percentage);
             lastPercentage = percentage;
         }
     });
 
     ArduinoOTA.onError([this](ota_error_t error) {
         isOtaInProgress = false;
-        Logger::instance().log("OTAManager", Logger::Level::ERROR, "OTA Error[%u]", error);
+        LOGGER_ERROR("OTAManager", "OTA Error[%u]", error);
         switch (error) {
-            case OTA_AUTH_ERROR: Logger::instance().log("OTAManager", Logger::Level::ERROR, "Auth Failed"); break;
-            case OTA_BEGIN_ERROR: Logger::instance().log("OTAManager", Logger::Level::ERROR, "Begin Failed"); break;
-            case OTA_CONNECT_ERROR: Logger::instance().log("OTAManager", Logger::Level::ERROR, "Connect Failed"); break;
-            case OTA_RECEIVE_ERROR: Logger::instance().log("OTAManager", Logger::Level::ERROR, "Receive Failed"); break;
-            case OTA_END_ERROR: Logger::instance().log("OTAManager", Logger::Level::ERROR, "End Failed"); break;
+            case OTA_AUTH_ERROR: LOGGER_ERROR("OTAManager", "Auth Failed"); break;
+            case OTA_BEGIN_ERROR: LOGGER_ERROR("OTAManager", "Begin Failed"); break;
+            case OTA_CONNECT_ERROR: LOGGER_ERROR("OTAManager", "Connect Failed"); break;
+            case OTA_RECEIVE_ERROR: LOGGER_ERROR("OTAManager", "Receive Failed"); break;
+            case OTA_END_ERROR: LOGGER_ERROR("OTAManager", "End Failed"); break;
         }
     });
 
     ArduinoOTA.onEnd([this] {
         isOtaInProgress = false;
-        Logger::instance().log("OTAManager", Logger::Level::INFO, "OTA update finished successfully");
+        LOGGER_INFO("OTAManager", "OTA update finished successfully");
     });
 
     ArduinoOTA.begin();
-    Logger::instance().log("OTAManager", Logger::Level::INFO, "OTA Manager initialized");
+    LOGGER_INFO("OTAManager", "OTA Manager initialized");
 
     xTaskCreate(
         otaTask,          // Function that implements the task
@@ -2,17 +2,16 @@
 #include <WiFi.h>
 
 ESPTelemetry::ESPTelemetry(ESPMQTTManager& mqttManager, const char* topic)
-    : logger(Logger::instance()),
-      mqttManager(mqttManager),
+    : mqttManager(mqttManager),
       topic(topic) {}
 
 void ESPTelemetry::setTopic(const char* newTopic) {
     topic = newTopic;
-    logger.log("Telemetry", Logger::Level::INFO, "Telemetry topic set to: {}", newTopic);
+    LOGGER_FMT_INFO("Telemetry", "Telemetry topic set to: {}", newTopic);
 }
 
 bool ESPTelemetry::publishTelemetry() {
-    logger.log("Telemetry", Logger::Level::INFO, "Preparing telemetry...");
+    LOGGER_INFO("Telemetry", "Preparing telemetry...");
     
     JsonDocument doc;        
     doc["free_heap"] = xPortGetFreeHeapSize();
@@ -30,18 +29,43 @@ bool ESPTelemetry::publishTelemetry() {
         doc[key] = dataProvider();
     }
 
-    String telemetryJson;
-    serializeJson(doc, telemetryJson);
-    
-    if (mqttManager.publish(topic, telemetryJson.c_str())) {
-        logger.log("Telemetry", Logger::Level::INFO, "Telemetry published successfully");
+    // Serialize straight into the socket, or the offline buffer, without an intermediate String
+    ESPMQTTManager::PublishWriter writer = mqttManager.beginPublish(topic, measureJson(doc));
+    serializeJson(doc, writer);
+
+    if (writer.end()) {
+        LOGGER_INFO("Telemetry", "Telemetry published successfully");
         return true;
     } else {
-        logger.log("Telemetry", Logger::Level::ERROR, "Failed to publish telemetry");
+        LOGGER_ERROR("Telemetry", "Failed to publish telemetry");
         return false;
     }
 }
 
+bool ESPTelemetry::publishCrashLog(const char* crashTopic) {
+    ESPCrashLog& crashLog = ESPCrashLog::instance();
+    size_t count = crashLog.getPreviousBootCount();
+
+    JsonDocument doc;
+    doc["reset_reason"] = crashLog.getResetReason();
+    doc["entries"] = count;
+    ESPMQTTManager::PublishWriter writer = mqttManager.beginPublish(crashTopic, measureJson(doc));
+    serializeJson(doc, writer);
+
+    // One message per entry keeps each payload within the MQTT client's buffer
+    bool published = writer.end();
+    for (size_t i = 0; i < count && published; ++i) {
+        published = mqttManager.publish(crashTopic, crashLog.getPreviousBootJson(i).c_str());
+    }
+
+    if (published) {
+        LOGGER_INFO("Telemetry", "Crash log published (%u entries)", static_cast<unsigned>(count));
+    } else {
+        LOGGER_ERROR("Telemetry", "Failed to publish crash log");
+    }
+    return published;
+}
+
 void ESPTelemetry::addTaskToMonitor(TaskHandle_t task, const char* taskName) {
     monitoredTasks.push_back({task, taskName});
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <map>
 #include <vector>
 #include "ESPLogger.h"
+#include "ESPCrashLog.h"
 #include "MQTTManager.h"
 
 class ESPTelemetry {
@@ -19,10 +20,10 @@ public:
     
     void addCustomData(const char* key, std::function<UBaseType_t()> dataProvider);
     bool publishTelemetry();
+    bool publishCrashLog(const char* crashTopic);
     void addTaskToMonitor(TaskHandle_t task, const char* taskName);
 
 private:
-    Logger& logger;
     ESPMQTTManager& mqttManager;
     const char* topic;
     std::map<const char*, std::function<String()>> customData;
@@ -1,14 +1,17 @@
 #include "ESPTimeSetup.h"
 #include <Arduino.h>
+#include <sys/time.h>
+#include "esp_sntp.h"
+#include "esp_timer.h"
 
 ESPTimeSetup::ESPTimeSetup(const char* ntpServer, long gmtOffset_sec, int daylightOffset_sec)
-    : logger(Logger::instance()),
-      ntpServer(ntpServer), 
+    : ntpServer(ntpServer), 
       gmtOffset_sec(gmtOffset_sec), 
       daylightOffset_sec(daylightOffset_sec),
       timeInitialized(false) {}
 
 bool ESPTimeSetup::begin(uint32_t timeout_ms) {
+    sntp_set_time_sync_notification_cb(onTimeSync);
     configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
     
     uint32_t start = millis();
@@ -17,24 +20,27 @@ bool ESPTimeSetup::begin(uint32_t timeout_ms) {
     }
 
     if (getLocalTime(&timeinfo)) {
-        logger.log("TimeSetup", Logger::Level::INFO, "Time synchronized with NTP server");
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        onTimeSync(&tv);
+        LOGGER_INFO("TimeSetup", "Time synchronized with NTP server");
         timeInitialized = true;
         return true;
     } else {
-        logger.log("TimeSetup", Logger::Level::ERROR, "Failed to obtain time from NTP server");
+        LOGGER_ERROR("TimeSetup", "Failed to obtain time from NTP server");
         return false;
     }
 }
 
 void ESPTimeSetup::setNTPServer(const char* server) {
     ntpServer = server;
-    logger.log("TimeSetup", Logger::Level::INFO, "NTP server set to: {}", server);
+    LOGGER_FMT_INFO("TimeSetup", "NTP server set to: {}", server);
 }
 
 void ESPTimeSetup::setTimeOffsets(long gmtOffset, int daylightOffset) {
     gmtOffset_sec = gmtOffset;
     daylightOffset_sec = daylightOffset;
-    logger.log("TimeSetup", Logger::Level::INFO, "Time offsets updated. GMT: {}s, DST: {}s", gmtOffset, daylightOffset);
+    LOGGER_FMT_INFO("TimeSetup", "Time offsets updated. GMT: {}s, DST: {}s", gmtOffset, daylightOffset);
 }
 
 bool ESPTimeSetup::isTimeInitialized() const {
@@ -57,4 +63,10 @@ time_t ESPTimeSetup::getCurrentTime() {
     time_t now;
     time(&now);
     return now;
-}
\ No newline at end of file
+}
+
+void ESPTimeSetup::onTimeSync(struct timeval* tv) {
+    // Cache the wall-clock time at boot so log entries only need the monotonic timer
+    int64_t now = static_cast<int64_t>(tv->tv_sec) * 1000000 + tv->tv_usec;
+    Logger::instance().setEpochOffset(now - esp_timer_get_time());
+}
@@ -18,7 +18,8 @@ public:
     time_t getCurrentTime();
 
 private:
-    Logger& logger;
+    static void onTimeSync(struct timeval* tv);
+
     const char* ntpServer;
     long gmtOffset_sec;
     int daylightOffset_sec;
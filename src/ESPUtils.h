@@ -2,10 +2,13 @@
 #define ESP_UTILS_H
 
 #include "ESPLogger.h"
+#include "ESPLogFile.h"
+#include "ESPCrashLog.h"
 #include "ESPOTASetup.h"
 #include "ESPTelemetry.h"
 #include "ESPTimeSetup.h"
 #include "MQTTManager.h"
+#include "MQTTSpool.h"
 #include "ESPWifi.h"
 
 #endif // ESP_UTILS_H
\ No newline at end of file
@@ -1,14 +1,14 @@
 #include "ESPWiFi.h"
 
 WiFiWrapper::WiFiWrapper(const char* ssid, const char* password)
-    : ssid(ssid), password(password), logger(Logger::instance()), reconnectTaskHandle(NULL), useStaticIP(false) {
-    logger.log(LOG_TAG, LogLevel::DEBUG, "WiFiWrapper instance created");
+    : ssid(ssid), password(password), reconnectTaskHandle(NULL), useStaticIP(false) {
+    LOGGER_DEBUG(LOG_TAG, "WiFiWrapper instance created");
 }
 
 bool WiFiWrapper::connect() {
     if (useStaticIP) {
         if (!WiFi.config(staticIP, gateway, subnet)) {
-            logger.log(LOG_TAG, LogLevel::ERROR, "Failed to configure static IP");
+            LOGGER_ERROR(LOG_TAG, "Failed to configure static IP");
             return false;
         }
     }
@@ -17,13 +17,13 @@ bool WiFiWrapper::connect() {
         WiFi.setHostname(hostname.c_str());
     }
 
-    logger.log(LOG_TAG, LogLevel::INFO, "Connecting to WiFi SSID: %s", ssid);
+    LOGGER_INFO(LOG_TAG, "Connecting to WiFi SSID: %s", ssid);
     WiFi.begin(ssid, password);
     int attempts = 0;
     while (WiFi.status() != WL_CONNECTED && attempts < 20) {
         vTaskDelay(pdMS_TO_TICKS(500));
         attempts++;
-        logger.log(LOG_TAG, LogLevel::DEBUG, "WiFi connection attempt: %d", attempts);
+        LOGGER_DEBUG(LOG_TAG, "WiFi connection attempt: %d", attempts);
     }
     return WiFi.status() == WL_CONNECTED;
 }
@@ -32,12 +32,12 @@ void WiFiWrapper::reconnectTask(void* pvParameters) {
     WiFiWrapper* wifiWrapper = static_cast<WiFiWrapper*>(pvParameters);
     for (;;) {
         if (WiFi.status() != WL_CONNECTED) {
-            wifiWrapper->logger.log(LOG_TAG, LogLevel::WARNING, "WiFi disconnected. Attempting to reconnect...");
+            LOGGER_WARNING(LOG_TAG, "WiFi disconnected. Attempting to reconnect...");
             if (wifiWrapper->connect()) {
-                wifiWrapper->logger.log(LOG_TAG, LogLevel::INFO, "WiFi reconnected successfully");
+                LOGGER_INFO(LOG_TAG, "WiFi reconnected successfully");
                 wifiWrapper->logConnectionDetails();
             } else {
-                wifiWrapper->logger.log(LOG_TAG, LogLevel::ERROR, "WiFi reconnection failed");
+                LOGGER_ERROR(LOG_TAG, "WiFi reconnection failed");
             }
         }
         vTaskDelay(pdMS_TO_TICKS(RECONNECT_INTERVAL));
@@ -45,15 +45,15 @@ void WiFiWrapper::reconnectTask(void* pvParameters) {
 }
 
 void WiFiWrapper::logConnectionDetails() {
-    logger.log(LOG_TAG, LogLevel::INFO, "Connection Details:");
-    logger.log(LOG_TAG, LogLevel::INFO, "IP: %s", WiFi.localIP().toString().c_str());
-    logger.log(LOG_TAG, LogLevel::INFO, "Gateway: %s", WiFi.gatewayIP().toString().c_str());
-    logger.log(LOG_TAG, LogLevel::INFO, "Subnet: %s", WiFi.subnetMask().toString().c_str());
-    logger.log(LOG_TAG, LogLevel::INFO, "DNS: %s", WiFi.dnsIP().toString().c_str());
-    logger.log(LOG_TAG, LogLevel::INFO, "Hostname: %s", WiFi.getHostname());
-    logger.log(LOG_TAG, LogLevel::INFO, "MAC: %s", WiFi.macAddress().c_str());
-    logger.log(LOG_TAG, LogLevel::INFO, "SSID: %s", WiFi.SSID().c_str());
-    logger.log(LOG_TAG, LogLevel::INFO, "RSSI: %d dBm", WiFi.RSSI());
+    LOGGER_INFO(LOG_TAG, "Connection Details:");
+    LOGGER_FMT_INFO(LOG_TAG, "IP: {}", WiFi.localIP());
+    LOGGER_FMT_INFO(LOG_TAG, "Gateway: {}", WiFi.gatewayIP());
+    LOGGER_FMT_INFO(LOG_TAG, "Subnet: {}", WiFi.subnetMask());
+    LOGGER_FMT_INFO(LOG_TAG, "DNS: {}", WiFi.dnsIP());
+    LOGGER_INFO(LOG_TAG, "Hostname: %s", WiFi.getHostname());
+    LOGGER_INFO(LOG_TAG, "MAC: %s", WiFi.macAddress().c_str());
+    LOGGER_INFO(LOG_TAG, "SSID: %s", WiFi.SSID().c_str());
+    LOGGER_INFO(LOG_TAG, "RSSI: %d dBm", WiFi.RSSI());
 }
 
 IPAddress WiFiWrapper::stringToIP(const String& ipString) {
@@ -61,7 +61,7 @@ IPAddress WiFiWrapper::stringToIP(const String& ipString) {
     if (ip.fromString(ipString)) {
         return ip;
     } else {
-        logger.log(LOG_TAG, LogLevel::ERROR, "Invalid IP address format: %s", ipString.c_str());
+        LOGGER_ERROR(LOG_TAG, "Invalid IP address format: %s", ipString.c_str());
         return IPAddress(INADDR_NONE);  // Return an invalid IP address
     }
 }
@@ -72,25 +72,25 @@ void WiFiWrapper::setStaticIP(const String& ip, const String& gateway, const Str
     this->subnet = stringToIP(subnet);
     useStaticIP = true;
 
-    logger.log(LOG_TAG, LogLevel::INFO, "Static IP set: %s", ip.c_str());
-    logger.log(LOG_TAG, LogLevel::INFO, "Gateway: %s", this->gateway.toString().c_str());
-    logger.log(LOG_TAG, LogLevel::INFO, "Subnet: %s", this->subnet.toString().c_str());
+    LOGGER_INFO(LOG_TAG, "Static IP set: %s", ip.c_str());
+    LOGGER_INFO(LOG_TAG, "Gateway: %s", this->gateway.toString().c_str());
+    LOGGER_INFO(LOG_TAG, "Subnet: %s", this->subnet.toString().c_str());
 }
 
 void WiFiWrapper::setHostname(const String& hostname) {
     this->hostname = hostname;
-    logger.log(LOG_TAG, LogLevel::INFO, "Hostname set: %s", hostname.c_str());
+    LOGGER_INFO(LOG_TAG, "Hostname set: %s", hostname.c_str());
 }
 
 bool WiFiWrapper::begin() {
-    logger.log(LOG_TAG, LogLevel::INFO, "Initializing WiFi connection");
+    LOGGER_INFO(LOG_TAG, "Initializing WiFi connection");
     WiFi.mode(WIFI_STA);
     bool connected = connect();
     if (connected) {
-        logger.log(LOG_TAG, LogLevel::INFO, "WiFi connected successfully");
+        LOGGER_INFO(LOG_TAG, "WiFi connected successfully");
         logConnectionDetails();
     } else {
-        logger.log(LOG_TAG, LogLevel::ERROR, "Initial WiFi connection failed, but reconnection task is running");
+        LOGGER_ERROR(LOG_TAG, "Initial WiFi connection failed, but reconnection task is running");
     }
 
     xTaskCreate(
@@ -101,7 +101,7 @@ bool WiFiWrapper::begin() {
         TASK_PRIORITY,
         &reconnectTaskHandle
     );
-    logger.log(LOG_TAG, LogLevel::DEBUG, "WiFi reconnection task created");
+    LOGGER_DEBUG(LOG_TAG, "WiFi reconnection task created");
 
     return connected;
 }
@@ -120,10 +120,10 @@ String WiFiWrapper::getHostname() {
 
 bool WiFiWrapper::setupMDNS(const char* hostname) {
     if (MDNS.begin(hostname)) {
-        logger.log(LOG_TAG, LogLevel::INFO, "mDNS responder started. Hostname: %s.local", hostname);
+        LOGGER_INFO(LOG_TAG, "mDNS responder started. Hostname: %s.local", hostname);
         return true;
     } else {
-        logger.log(LOG_TAG, LogLevel::ERROR, "Error setting up mDNS responder!");
+        LOGGER_ERROR(LOG_TAG, "Error setting up mDNS responder!");
         return false;
     }
 }
@@ -131,6 +131,6 @@ bool WiFiWrapper::setupMDNS(const char* hostname) {
 WiFiWrapper::~WiFiWrapper() {
     if (reconnectTaskHandle != NULL) {
         vTaskDelete(reconnectTaskHandle);
-        logger.log(LOG_TAG, LogLevel::DEBUG, "WiFi reconnection task deleted");
+        LOGGER_DEBUG(LOG_TAG, "WiFi reconnection task deleted");
     }
 }
\ No newline at end of file
@@ -11,7 +11,6 @@ class WiFiWrapper {
 private:
     const char* ssid;
     const char* password;
-    Logger& logger;
     TaskHandle_t reconnectTaskHandle;
     static const uint32_t STACK_SIZE = 4096;
     static const UBaseType_t TASK_PRIORITY = 1;
@@ -1,44 +1,90 @@
 #include "MQTTManager.h"
+#include <algorithm>
+#include <string>
+#include <lwip/sockets.h>
+
+namespace {
+
+constexpr uint16_t KEEP_ALIVE_S = 60;            ///< MQTT keepalive announced to the broker
+constexpr uint32_t KEEPALIVE_CHECK_MS = 1000;    ///< Longest time between two PubSubClient::loop() calls
+constexpr uint8_t MAX_PACKETS_PER_WAKE = 16;     ///< Inbound packets handled before publishes get a turn
+constexpr uint8_t MAX_BACKOFF_SHIFT = 16;        ///< Limits the doubling so the delay cannot overflow
+
+constexpr uint8_t MQTT_PUBLISH_TYPE = 0x30;       ///< PUBLISH packet type in the fixed header
+constexpr uint8_t MQTT_PUBACK_TYPE = 4;           ///< PUBACK packet type, upper nibble of the fixed header
+constexpr uint8_t MQTT_DUP_FLAG = 0x08;           ///< Fixed header flag of a retransmitted PUBLISH
+constexpr uint8_t MQTT_QOS1_FLAG = 0x02;          ///< Fixed header QoS 1 bits
+
+constexpr uint32_t EVENT_PUBLISH = 1 << 0;       ///< publish() queued an item
+constexpr uint32_t EVENT_RECONNECT = 1 << 1;     ///< Reconnect delay expired
+constexpr uint32_t EVENT_STOP = 1 << 2;          ///< stop() was called
+
+} // namespace
 
 ESPMQTTManager::ESPMQTTManager(const Config& config)
-    : logger(Logger::instance()),
-      config(config),
+    : config(config),
       espClient(),
-      mqttClient(espClient),
+      ackClient(espClient, *this),
+      mqttClient(ackClient),
       taskHandle(NULL),
       mqttMutex(xSemaphoreCreateMutex()),
       running(false),
       retryCount(0),
-      publishBuffer(xQueueCreate(config.publishBufferSize, sizeof(PublishItem))) {}
+      reconnectTimer(xTimerCreate("MQTT Reconnect", std::max<TickType_t>(1, pdMS_TO_TICKS(config.reconnectInterval)),
+                                  pdFALSE, this, reconnectTimerCallback)),
+      arenaMutex(xSemaphoreCreateMutex()),
+      publishArena(config.publishArenaSize),
+      arenaHead(0),
+      arenaTail(0),
+      publishItems(std::max<size_t>(1, config.publishBufferSize)),
+      itemFront(0),
+      itemCount(0),
+      sendIndex(0),
+      inFlightCount(0),
+      nextPacketId(1),
+      spoolUncommitted(false),
+      spoolReadSegment(0),
+      spoolCommittedSegment(0),
+      spoolCommittedAt(0),
+      spoolDrainedAt(0) {}
 
 ESPMQTTManager::~ESPMQTTManager() {
     stop();
+    xTimerDelete(reconnectTimer, portMAX_DELAY);
     vSemaphoreDelete(mqttMutex);
-    vQueueDelete(publishBuffer);
+    vSemaphoreDelete(arenaMutex);
 }
 
 bool ESPMQTTManager::begin() {
     setupTLS();
     mqttClient.setServer(config.server, config.port);
-    mqttClient.setKeepAlive(60);
-    logger.log("MQTTManager", Logger::Level::INFO, "MQTT client configured with TLS");
+    mqttClient.setKeepAlive(KEEP_ALIVE_S);
+    LOGGER_INFO("MQTTManager", "MQTT client configured with TLS");
 
     running = true;
-    BaseType_t result = xTaskCreate(taskWrapper, "MQTT Task", 8192, this, 1, &taskHandle);
+    TaskHandle_t handle = NULL;
+    BaseType_t result = xTaskCreate(taskWrapper, "MQTT Task", 8192, this, 1, &handle);
     if (result != pdPASS) {
-        logger.log("MQTTManager", Logger::Level::ERROR, "Failed to create MQTT task");
+        LOGGER_ERROR("MQTTManager", "Failed to create MQTT task");
         running = false;
         return false;
     }
+    taskHandle = handle;
+    // Wake-ups sent before the handle was stored went nowhere
+    notify(EVENT_RECONNECT);
     return true;
 }
 
 void ESPMQTTManager::stop() {
     running = false;
     if (taskHandle != NULL) {
-        vTaskDelete(taskHandle);
-        taskHandle = NULL;
+        notify(EVENT_STOP);
+        // The task clears the handle once it has left its loop and released the mutex
+        while (taskHandle != NULL) {
+            vTaskDelay(1);
+        }
     }
+    xTimerStop(reconnectTimer, portMAX_DELAY);
     disconnect();
 }
 
@@ -48,43 +94,126 @@ void ESPMQTTManager::taskWrapper(void* pvParameters) {
 }
 
 void ESPMQTTManager::task() {
-    TickType_t xLastWakeTime = xTaskGetTickCount();
-    const TickType_t xFrequency = pdMS_TO_TICKS(config.reconnectInterval);
-
     while (running) {
+        bool connected = false;
+        bool buffered = false;
         if (xSemaphoreTake(mqttMutex, portMAX_DELAY) == pdTRUE) {
-            if (!mqttClient.connected()) {
-                logger.log("MQTTManager", Logger::Level::INFO, "Attempting MQTT connection... (Attempt %d of %d)", retryCount + 1, config.maxRetries);
-                
-                if (connect()) {
-                    logger.log("MQTTManager", Logger::Level::INFO, "Connected to MQTT broker");
-                    retryCount = 0;
-                    resubscribe();
-                } else {
-                    retryCount++;
-                    logger.log("MQTTManager", Logger::Level::ERROR, "Failed to connect to MQTT broker, rc=%d, retry=%d/%d", mqttClient.state(), retryCount, config.maxRetries);
-                    
-                    if (retryCount >= config.maxRetries) {
-                        logger.log("MQTTManager", Logger::Level::ERROR, "Max retries reached. Resetting retry count.");
-                        retryCount = 0;
-                    }
-                }
+            connected = mqttClient.connected();
+            if (!connected && xTimerIsTimerActive(reconnectTimer) == pdFALSE) {
+                connected = attemptConnect();
+            }
+            if (connected) {
+                buffered = service();
             }
-            
-            mqttClient.loop();
-            processPublishBuffer();
             xSemaphoreGive(mqttMutex);
         }
-        
-        vTaskDelay(xFrequency);
+
+        // Bytes TLS already decrypted never make the socket readable, so select() would sit on them
+        if (!buffered) {
+            waitForEvents(connected);
+        }
     }
 
+    taskHandle = NULL;
     vTaskDelete(NULL);
 }
 
+bool ESPMQTTManager::attemptConnect() {
+    LOGGER_INFO("MQTTManager", "Attempting MQTT connection... (Attempt %d of %d)", retryCount + 1, config.maxRetries);
+
+    if (connect()) {
+        LOGGER_INFO("MQTTManager", "Connected to MQTT broker");
+        retryCount = 0;
+        resubscribe();
+        requeueInFlight();
+        return true;
+    }
+
+    retryCount++;
+    const uint32_t delay = reconnectDelay();
+    LOGGER_LOG_FIELDS("MQTTManager", Logger::Level::ERROR, "Failed to connect to MQTT broker",
+                      Logger::field("rc", mqttClient.state()), Logger::field("retry", retryCount),
+                      Logger::field("max_retries", config.maxRetries), Logger::field("retry_in_ms", delay));
+
+    if (retryCount >= config.maxRetries) {
+        LOGGER_ERROR("MQTTManager", "Max retries reached. Resetting retry count.");
+        retryCount = 0;
+    }
+
+    // Changing the period also starts the timer; its callback wakes the task
+    xTimerChangePeriod(reconnectTimer, std::max<TickType_t>(1, pdMS_TO_TICKS(delay)), portMAX_DELAY);
+    return false;
+}
+
+uint32_t ESPMQTTManager::reconnectDelay() const {
+    const uint8_t shift = std::min<uint16_t>(retryCount > 0 ? retryCount - 1 : 0, MAX_BACKOFF_SHIFT);
+    const uint64_t delay = static_cast<uint64_t>(config.reconnectInterval) << shift;
+    return static_cast<uint32_t>(std::min<uint64_t>(delay, std::max(config.reconnectInterval, config.maxReconnectInterval)));
+}
+
+bool ESPMQTTManager::service() {
+    // PubSubClient reads at most one packet per loop(), so keep going while TLS has data buffered
+    uint8_t packets = 0;
+    do {
+        mqttClient.loop();
+    } while (++packets < MAX_PACKETS_PER_WAKE && espClient.available() > 0);
+
+    processPublishBuffer();
+    return espClient.available() > 0;
+}
+
+void ESPMQTTManager::waitForEvents(bool connected) {
+    uint32_t events = 0;
+    if (!connected) {
+        // Only the reconnect timer, a publish or stop() can give a disconnected task work
+        xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+        return;
+    }
+
+    // lwIP's select() cannot be woken by a task notification, so wait on the
+    // socket in pollInterval slices and check for notifications in between
+    const TickType_t start = xTaskGetTickCount();
+    const TickType_t keepAlive = pdMS_TO_TICKS(KEEPALIVE_CHECK_MS);
+    const TickType_t slice = std::max<TickType_t>(1, pdMS_TO_TICKS(config.pollInterval));
+    while (xTaskNotifyWait(0, UINT32_MAX, &events, 0) != pdTRUE) {
+        const TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= keepAlive || waitForSocket(std::min<TickType_t>(keepAlive - elapsed, slice))) {
+            return;
+        }
+    }
+}
+
+bool ESPMQTTManager::waitForSocket(TickType_t timeout) {
+    const int fd = espClient.fd();
+    if (fd < 0) {
+        // Without a descriptor to wait on, poll the client every slice
+        vTaskDelay(timeout);
+        return true;
+    }
+
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(fd, &readable);
+    const uint32_t ms = timeout * portTICK_PERIOD_MS;
+    timeval tv = {static_cast<time_t>(ms / 1000), static_cast<suseconds_t>((ms % 1000) * 1000)};
+    // A closed or failed socket also reports readable, so loop() notices the disconnect
+    return select(fd + 1, &readable, NULL, NULL, &tv) != 0;
+}
+
+void ESPMQTTManager::notify(uint32_t events) {
+    TaskHandle_t handle = taskHandle;
+    if (handle != NULL) {
+        xTaskNotify(handle, events, eSetBits);
+    }
+}
+
+void ESPMQTTManager::reconnectTimerCallback(TimerHandle_t timer) {
+    static_cast<ESPMQTTManager*>(pvTimerGetTimerID(timer))->notify(EVENT_RECONNECT);
+}
+
 bool ESPMQTTManager::connect() {
     String clientId = getClientId();
-    logger.log("MQTTManager", Logger::Level::INFO, "Attempting connection with client ID: %s", clientId.c_str());
+    LOGGER_INFO("MQTTManager", "Attempting connection with client ID: %s", clientId.c_str());
 
     bool connected = false;
     if (config.authMode == AuthMode::TLS_CERT_AUTH) {
@@ -101,59 +230,525 @@ void ESPMQTTManager::disconnect() {
         mqttClient.disconnect();
         xSemaphoreGive(mqttMutex);
     }
-    logger.log("MQTTManager", Logger::Level::INFO, "Disconnected from MQTT broker");
+    LOGGER_INFO("MQTTManager", "Disconnected from MQTT broker");
 }
 
-bool ESPMQTTManager::publish(const char* topic, const char* payload, bool retained) {
-    PublishItem item = {String(topic), String(payload), retained};
-    
-    if (xSemaphoreTake(mqttMutex, pdMS_TO_TICKS(config.publishTimeout)) == pdTRUE) {
+bool ESPMQTTManager::publish(const char* topic, const char* payload, bool retained, uint8_t qos) {
+    return publish(topic, reinterpret_cast<const uint8_t*>(payload), strlen(payload), retained, qos);
+}
+
+bool ESPMQTTManager::publish(const char* topic, const uint8_t* payload, size_t length, bool retained, uint8_t qos) {
+    // While older messages wait on flash, new ones queue behind them
+    const bool spooled = spooling();
+
+    // QoS 1 messages are kept in the buffer until the broker acknowledges them
+    if (qos == 0 && !spooled && xSemaphoreTake(mqttMutex, pdMS_TO_TICKS(config.publishTimeout)) == pdTRUE) {
         if (mqttClient.connected()) {
-            bool result = mqttClient.publish(topic, payload, retained);
+            bool result = mqttClient.publish(topic, payload, length, retained);
             xSemaphoreGive(mqttMutex);
             if (result) {
-                logger.log("MQTTManager", Logger::Level::INFO, "Published to topic: %s", topic);
+                LOGGER_INFO("MQTTManager", "Published to topic: %s", topic);
             } else {
-                logger.log("MQTTManager", Logger::Level::ERROR, "Failed to publish to topic: %s", topic);
+                LOGGER_ERROR("MQTTManager", "Failed to publish to topic: %s", topic);
             }
             return result;
         }
         xSemaphoreGive(mqttMutex);
     }
     
+    if (!fitsArena(topic, length)) {
+        return false;
+    }
+
     // If we couldn't publish immediately, add to buffer
-    if (xQueueSend(publishBuffer, &item, 0) != pdTRUE) {
-        logger.log("MQTTManager", Logger::Level::ERROR, "Failed to add publish message to buffer. Buffer full.");
+    if (!spooled && enqueuePublish(topic, payload, length, retained, qos)) {
+        LOGGER_INFO("MQTTManager", "Added publish message to buffer for topic: %s", topic);
+        notify(EVENT_PUBLISH);
+        return true;
+    }
+    if (config.spool != nullptr && config.spool->append(topic, payload, length, retained, qos)) {
+        LOGGER_INFO("MQTTManager", "Added publish message to flash spool for topic: %s", topic);
+        notify(EVENT_PUBLISH);
+        return true;
+    }
+
+    LOGGER_ERROR("MQTTManager", "Failed to add publish message to buffer. Buffer full.");
+    return false;
+}
+
+bool ESPMQTTManager::enqueuePublish(const char* topic, const uint8_t* payload, size_t length, bool retained, uint8_t qos,
+                                    const ESPMQTTSpool::Message* source) {
+    PublishItem item;
+    if (!beginArenaRecord(topic, length, retained, qos, source, item)) {
         return false;
     }
-    
-    logger.log("MQTTManager", Logger::Level::INFO, "Added publish message to buffer for topic: %s", topic);
+    memcpy(arenaPayload(item), payload, length);
+    endArenaRecord(item, true);
     return true;
 }
 
-void ESPMQTTManager::processPublishBuffer() {
-    PublishItem item;
-    while (xQueueReceive(publishBuffer, &item, 0) == pdTRUE) {
-        if (mqttClient.connected()) {
-            bool result = mqttClient.publish(item.topic.c_str(), item.payload.c_str(), item.retained);
-            if (result) {
-                logger.log("MQTTManager", Logger::Level::INFO, "Published buffered message to topic: %s", item.topic.c_str());
-            } else {
-                logger.log("MQTTManager", Logger::Level::ERROR, "Failed to publish buffered message to topic: %s", item.topic.c_str());
-                // Re-add to queue if publish failed
-                if (xQueueSend(publishBuffer, &item, 0) != pdTRUE) {
-                    logger.log("MQTTManager", Logger::Level::ERROR, "Failed to re-add publish message to buffer. Buffer full.");
-                }
-                break;  // Stop processing if we couldn't publish
+bool ESPMQTTManager::fitsArena(const char* topic, size_t length) {
+    const size_t topicLength = strlen(topic);
+    const size_t size = topicLength + 1 + length;
+    if (topicLength > UINT16_MAX || size > publishArena.size()) {
+        LOGGER_ERROR("MQTTManager", "Message for topic %s does not fit in the publish buffer (%u bytes)", topic,
+                     static_cast<unsigned>(size));
+        return false;
+    }
+    return true;
+}
+
+bool ESPMQTTManager::beginArenaRecord(const char* topic, size_t length, bool retained, uint8_t qos,
+                                      const ESPMQTTSpool::Message* source, PublishItem& item) {
+    const size_t topicLength = strlen(topic);
+    const size_t size = topicLength + 1 + length;
+
+    // On success the lock stays held until endArenaRecord, so records are queued in the order they were reserved
+    if (xSemaphoreTake(arenaMutex, portMAX_DELAY) == pdTRUE) {
+        size_t offset = 0;
+        if (itemCount < publishItems.size() && reserveArena(size, offset)) {
+            item = {static_cast<uint32_t>(offset), static_cast<uint32_t>(length), 0, static_cast<uint16_t>(topicLength),
+                    0, retained, static_cast<uint8_t>(qos > 0 ? 1 : 0), false, source != nullptr, PublishState::QUEUED,
+                    source != nullptr ? source->segment : 0, source != nullptr ? source->offset : 0};
+            memcpy(publishArena.data() + offset, topic, topicLength + 1);
+            return true;
+        }
+        xSemaphoreGive(arenaMutex);
+    }
+    return false;
+}
+
+void ESPMQTTManager::endArenaRecord(const PublishItem& item, bool keep) {
+    if (keep) {
+        itemAt(itemCount++) = item;
+        arenaHead = item.offset + item.topicLength + 1 + item.payloadLength;
+    }
+    xSemaphoreGive(arenaMutex);
+}
+
+char* ESPMQTTManager::arenaPayload(const PublishItem& item) {
+    return publishArena.data() + item.offset + item.topicLength + 1;
+}
+
+bool ESPMQTTManager::reserveArena(size_t size, size_t& offset) const {
+    if (itemCount == 0) {
+        offset = 0;
+        return true;
+    }
+    if (arenaHead > arenaTail) {
+        // Free space after the head, then before the tail once the end is too short
+        if (size <= publishArena.size() - arenaHead) {
+            offset = arenaHead;
+            return true;
+        }
+        if (size <= arenaTail) {
+            offset = 0;
+            return true;
+        }
+        return false;
+    }
+    // The head has wrapped; equal positions with items queued mean the arena is full
+    if (size <= arenaTail - arenaHead) {
+        offset = arenaHead;
+        return true;
+    }
+    return false;
+}
+
+ESPMQTTManager::PublishItem& ESPMQTTManager::itemAt(size_t index) {
+    return publishItems[(itemFront + index) % publishItems.size()];
+}
+
+bool ESPMQTTManager::nextToSend(PublishItem& item, size_t& index) {
+    bool found = false;
+    if (xSemaphoreTake(arenaMutex, portMAX_DELAY) == pdTRUE) {
+        while (sendIndex < itemCount && itemAt(sendIndex).state != PublishState::QUEUED) {
+            ++sendIndex;
+        }
+        // Items go out in order, so a full window also holds back the QoS 0 items behind it
+        if (sendIndex < itemCount && (itemAt(sendIndex).qos == 0 || inFlightCount < config.inflightWindow)) {
+            PublishItem& next = itemAt(sendIndex);
+            if (next.qos > 0 && next.packetId == 0) {
+                next.packetId = nextPacketId;
+                nextPacketId = nextPacketId == UINT16_MAX ? 1 : nextPacketId + 1;
             }
+            item = next;
+            index = sendIndex;
+            found = true;
+        }
+        xSemaphoreGive(arenaMutex);
+    }
+    return found;
+}
+
+void ESPMQTTManager::markSent(size_t index) {
+    if (xSemaphoreTake(arenaMutex, portMAX_DELAY) == pdTRUE) {
+        PublishItem& item = itemAt(index);
+        if (item.qos > 0) {
+            item.state = PublishState::IN_FLIGHT;
+            item.sentAt = xTaskGetTickCount();
+            ++inFlightCount;
         } else {
-            // Re-add to queue if not connected
-            if (xQueueSend(publishBuffer, &item, 0) != pdTRUE) {
-                logger.log("MQTTManager", Logger::Level::ERROR, "Failed to re-add publish message to buffer. Buffer full.");
+            item.state = PublishState::DONE;
+        }
+        sendIndex = index + 1;
+        releaseDone();
+        xSemaphoreGive(arenaMutex);
+    }
+}
+
+void ESPMQTTManager::releaseDone() {
+    // Arena space is freed in FIFO order, so a finished item waits until everything before it is done
+    while (itemCount > 0 && itemAt(0).state == PublishState::DONE) {
+        const PublishItem& front = itemAt(0);
+        arenaTail = front.offset + front.topicLength + 1 + front.payloadLength;
+        itemFront = (itemFront + 1) % publishItems.size();
+        --itemCount;
+        sendIndex = sendIndex > 0 ? sendIndex - 1 : 0;
+    }
+    if (itemCount == 0) {
+        itemFront = 0;
+        arenaHead = 0;
+        arenaTail = 0;
+    }
+}
+
+void ESPMQTTManager::acknowledge(uint16_t packetId) {
+    bool matched = false;
+    if (xSemaphoreTake(arenaMutex, portMAX_DELAY) == pdTRUE) {
+        for (size_t i = 0; i < sendIndex && i < itemCount; ++i) {
+            PublishItem& item = itemAt(i);
+            if (item.state == PublishState::IN_FLIGHT && item.packetId == packetId) {
+                item.state = PublishState::DONE;
+                --inFlightCount;
+                matched = true;
+                releaseDone();
+                break;
+            }
+        }
+        xSemaphoreGive(arenaMutex);
+    }
+    if (!matched) {
+        LOGGER_DEBUG("MQTTManager", "PUBACK for unknown packet id %u", static_cast<unsigned>(packetId));
+    }
+}
+
+void ESPMQTTManager::requeueInFlight() {
+    size_t resent = 0;
+    if (xSemaphoreTake(arenaMutex, portMAX_DELAY) == pdTRUE) {
+        for (size_t i = 0; i < itemCount; ++i) {
+            PublishItem& item = itemAt(i);
+            if (item.state == PublishState::IN_FLIGHT) {
+                item.state = PublishState::QUEUED;
+                item.dup = true;
+                ++resent;
+            }
+        }
+        inFlightCount = 0;
+        sendIndex = 0;
+        xSemaphoreGive(arenaMutex);
+    }
+    if (resent > 0) {
+        LOGGER_INFO("MQTTManager", "Resending %u unacknowledged QoS 1 publishes", static_cast<unsigned>(resent));
+    }
+}
+
+bool ESPMQTTManager::ackOverdue() {
+    bool overdue = false;
+    if (xSemaphoreTake(arenaMutex, portMAX_DELAY) == pdTRUE) {
+        const TickType_t now = xTaskGetTickCount();
+        for (size_t i = 0; i < sendIndex && i < itemCount && !overdue; ++i) {
+            const PublishItem& item = itemAt(i);
+            overdue = item.state == PublishState::IN_FLIGHT && now - item.sentAt > pdMS_TO_TICKS(config.ackTimeout);
+        }
+        xSemaphoreGive(arenaMutex);
+    }
+    return overdue;
+}
+
+bool ESPMQTTManager::sendQos1(const PublishItem& item) {
+    // PubSubClient only builds QoS 0 PUBLISH packets, so the header is assembled here
+    uint8_t head[PublishWriter::STREAM_CHUNK_SIZE];
+    size_t used = 0;
+    head[used++] = MQTT_PUBLISH_TYPE | (item.dup ? MQTT_DUP_FLAG : 0) | MQTT_QOS1_FLAG | (item.retained ? 1 : 0);
+    uint32_t remaining = 2 + item.topicLength + 2 + item.payloadLength;
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        head[used++] = remaining > 0 ? digit | 0x80 : digit;
+    } while (remaining > 0);
+    head[used++] = item.topicLength >> 8;
+    head[used++] = item.topicLength & 0xFF;
+
+    // Gather the header, topic, packet id and a short payload into as few TLS records as possible
+    bool ok = true;
+    auto append = [&](const uint8_t* data, size_t size) {
+        while (ok && size > 0) {
+            const size_t count = std::min(size, sizeof(head) - used);
+            memcpy(head + used, data, count);
+            used += count;
+            data += count;
+            size -= count;
+            if (used == sizeof(head)) {
+                ok = ackClient.write(head, used) == used;
+                used = 0;
             }
-            break;  // Stop processing if not connected
         }
+    };
+    const uint8_t packetId[2] = {static_cast<uint8_t>(item.packetId >> 8), static_cast<uint8_t>(item.packetId & 0xFF)};
+    append(reinterpret_cast<const uint8_t*>(publishArena.data() + item.offset), item.topicLength);
+    append(packetId, sizeof(packetId));
+
+    const uint8_t* payload = reinterpret_cast<const uint8_t*>(arenaPayload(item));
+    if (item.payloadLength <= sizeof(head) - used) {
+        append(payload, item.payloadLength);
+        return ok && (used == 0 || ackClient.write(head, used) == used);
     }
+    return ok && (used == 0 || ackClient.write(head, used) == used) &&
+           ackClient.write(payload, item.payloadLength) == item.payloadLength;
+}
+
+void ESPMQTTManager::processPublishBuffer() {
+    if (ackOverdue()) {
+        LOGGER_WARNING("MQTTManager", "PUBACK overdue after %u ms; reconnecting to resend", static_cast<unsigned>(config.ackTimeout));
+        mqttClient.disconnect();
+        return;
+    }
+
+    drainSpool();
+
+    // Only this task sends and frees items, so the bytes of the item being sent stay put
+    PublishItem item;
+    size_t index = 0;
+    while (mqttClient.connected() && nextToSend(item, index)) {
+        const char* topic = publishArena.data() + item.offset;
+        const uint8_t* payload = reinterpret_cast<const uint8_t*>(arenaPayload(item));
+        bool result = item.qos > 0 ? sendQos1(item) : mqttClient.publish(topic, payload, item.payloadLength, item.retained);
+        if (!result) {
+            LOGGER_ERROR("MQTTManager", "Failed to publish buffered message to topic: %s", topic);
+            break;  // Keep the message queued and retry on the next pass
+        }
+        LOGGER_INFO("MQTTManager", "Published buffered message to topic: %s", topic);
+        markSent(index);
+    }
+}
+
+bool ESPMQTTManager::spooling() {
+    return config.spool != nullptr && !config.spool->empty();
+}
+
+void ESPMQTTManager::drainSpool() {
+    ESPMQTTSpool* spool = config.spool;
+    if (spool == nullptr) {
+        return;
+    }
+
+    if (spoolUncommitted) {
+        commitSpool();
+    }
+
+    // Allow spoolDrainRate messages per second, without saving up more than one second's worth
+    const TickType_t now = xTaskGetTickCount();
+    const uint32_t elapsedMs = std::min<uint32_t>((now - spoolDrainedAt) * portTICK_PERIOD_MS, 1000);
+    size_t budget = config.spoolDrainRate > 0 ? elapsedMs * config.spoolDrainRate / 1000 : SIZE_MAX;
+    if (budget == 0) {
+        return;
+    }
+    spoolDrainedAt = now;
+
+    ESPMQTTSpool::Message message;
+    for (; budget > 0 && spool->peek(message); --budget) {
+        const size_t size = strlen(message.topic) + 1 + message.length;
+        if (size <= publishArena.size() && !enqueuePublish(message.topic, message.payload, message.length,
+                                                           message.retained, message.qos, &message)) {
+            break;  // The arena is full; continue on a later pass
+        }
+        if (size > publishArena.size()) {
+            LOGGER_ERROR("MQTTManager", "Dropping spooled message for topic %s: larger than the publish buffer",
+                         message.topic);
+        }
+        spool->consume();
+        spoolReadSegment = message.segment;
+        spoolUncommitted = true;
+    }
+}
+
+void ESPMQTTManager::commitSpool() {
+    // Everything consumed from the spool is in the arena until delivered, so the oldest spooled item
+    // still there is where a reboot has to resume
+    bool pending = false;
+    uint32_t segment = 0;
+    uint32_t offset = 0;
+    if (xSemaphoreTake(arenaMutex, portMAX_DELAY) == pdTRUE) {
+        for (size_t i = 0; i < itemCount && !pending; ++i) {
+            const PublishItem& item = itemAt(i);
+            if (item.spooled && item.state != PublishState::DONE) {
+                pending = true;
+                segment = item.spoolSegment;
+                offset = item.spoolOffset;
+            }
+        }
+        xSemaphoreGive(arenaMutex);
+    }
+
+    // Every commit syncs head.bin, so only commit when it frees a segment, the interval has passed
+    // or the spool is drained, instead of after every message
+    const TickType_t now = xTaskGetTickCount();
+    const bool due = now - spoolCommittedAt >= pdMS_TO_TICKS(config.spoolCommitInterval);
+    if (pending) {
+        if ((due || segment != spoolCommittedSegment) && config.spool->commit(segment, offset)) {
+            spoolCommittedSegment = segment;
+            spoolCommittedAt = now;
+        }
+    } else if ((due || spoolReadSegment != spoolCommittedSegment || config.spool->empty()) && config.spool->commit()) {
+        spoolCommittedSegment = spoolReadSegment;
+        spoolCommittedAt = now;
+        spoolUncommitted = false;
+    }
+}
+
+size_t ESPMQTTManager::getPendingPublishCount() {
+    size_t count = 0;
+    if (xSemaphoreTake(arenaMutex, portMAX_DELAY) == pdTRUE) {
+        count = itemCount;
+        xSemaphoreGive(arenaMutex);
+    }
+    return count;
+}
+
+ESPMQTTManager::PublishWriter ESPMQTTManager::beginPublish(const char* topic, size_t length, bool retained, uint8_t qos) {
+    return PublishWriter(*this, topic, length, retained, qos);
+}
+
+ESPMQTTManager::PublishWriter::PublishWriter(ESPMQTTManager& manager, const char* topic, size_t length, bool retained,
+                                             uint8_t qos)
+    : manager(manager),
+      target(Target::NONE),
+      length(length),
+      written(0),
+      failed(false),
+      overflowed(false),
+      item(),
+      chunkLength(0) {
+    const bool spooled = manager.spooling();
+
+    // Connected: keep the client locked until end() so no other packet lands inside this one
+    if (qos == 0 && !spooled && xSemaphoreTake(manager.mqttMutex, pdMS_TO_TICKS(manager.config.publishTimeout)) == pdTRUE) {
+        if (manager.mqttClient.connected() && manager.mqttClient.beginPublish(topic, length, retained)) {
+            target = Target::SOCKET;
+            return;
+        }
+        xSemaphoreGive(manager.mqttMutex);
+    }
+
+    if (!manager.fitsArena(topic, length)) {
+        return;
+    }
+    if (!spooled && manager.beginArenaRecord(topic, length, retained, qos, nullptr, item)) {
+        target = Target::ARENA;
+    } else if (manager.config.spool != nullptr && manager.config.spool->beginAppend(topic, length, retained, qos)) {
+        target = Target::SPOOL;
+    } else {
+        LOGGER_ERROR("MQTTManager", "Failed to add publish message to buffer. Buffer full.");
+    }
+}
+
+ESPMQTTManager::PublishWriter::~PublishWriter() {
+    end();
+}
+
+size_t ESPMQTTManager::PublishWriter::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t ESPMQTTManager::PublishWriter::write(const uint8_t* buffer, size_t size) {
+    if (target == Target::NONE || failed) {
+        return 0;
+    }
+    if (size > length - written) {
+        // Reported by end(), since the writer holds the arena, spool or client lock until then
+        overflowed = true;
+        failed = true;
+        return 0;
+    }
+
+    if (target == Target::ARENA) {
+        memcpy(manager.arenaPayload(item) + written, buffer, size);
+        written += size;
+        return size;
+    }
+    if (target == Target::SPOOL) {
+        manager.config.spool->appendData(buffer, size);
+        written += size;
+        return size;
+    }
+
+    // Gather small writes, such as the single characters ArduinoJson emits, into one socket write
+    for (size_t copied = 0; copied < size;) {
+        const size_t count = std::min(size - copied, STREAM_CHUNK_SIZE - chunkLength);
+        memcpy(chunk + chunkLength, buffer + copied, count);
+        chunkLength += count;
+        copied += count;
+        if (chunkLength == STREAM_CHUNK_SIZE && !flushChunk()) {
+            return 0;
+        }
+    }
+    written += size;
+    return size;
+}
+
+bool ESPMQTTManager::PublishWriter::flushChunk() {
+    if (chunkLength > 0 && manager.mqttClient.write(chunk, chunkLength) != chunkLength) {
+        failed = true;
+    }
+    chunkLength = 0;
+    return !failed;
+}
+
+bool ESPMQTTManager::PublishWriter::end() {
+    if (target == Target::NONE) {
+        return false;
+    }
+    const bool complete = !failed && written == length;
+
+    // Everything below logs only after the lock it holds is released, since an observer may publish in turn
+    bool result = false;
+    if (target == Target::ARENA) {
+        // The record can be sent and freed once the arena is unlocked, so the topic is copied first
+        const std::string topic(complete ? manager.publishArena.data() + item.offset : "");
+        manager.endArenaRecord(item, complete);
+        if (complete) {
+            LOGGER_INFO("MQTTManager", "Added streamed publish to buffer for topic: %s", topic.c_str());
+            manager.notify(EVENT_PUBLISH);
+        }
+        result = complete;
+    } else if (target == Target::SPOOL) {
+        result = manager.config.spool->endAppend(complete);
+        if (result) {
+            LOGGER_INFO("MQTTManager", "Added streamed publish to flash spool");
+            manager.notify(EVENT_PUBLISH);
+        }
+    } else {
+        result = flushChunk() && complete && manager.mqttClient.endPublish() != 0;
+        if (!complete) {
+            // The broker is still waiting for the announced bytes, so the stream cannot be resumed
+            manager.mqttClient.disconnect();
+        }
+        xSemaphoreGive(manager.mqttMutex);
+        if (!complete) {
+            LOGGER_ERROR("MQTTManager", "Streamed publish ended after %u of %u bytes; reconnecting",
+                         static_cast<unsigned>(written), static_cast<unsigned>(length));
+        } else if (!result) {
+            LOGGER_ERROR("MQTTManager", "Failed to finish streamed publish");
+        }
+    }
+
+    if (overflowed) {
+        LOGGER_ERROR("MQTTManager", "Streamed publish exceeds its announced length of %u bytes",
+                     static_cast<unsigned>(length));
+    }
+    target = Target::NONE;
+    return result;
 }
 
 bool ESPMQTTManager::subscribe(const char* topic, uint8_t qos) {
@@ -162,13 +757,13 @@ bool ESPMQTTManager::subscribe(const char* topic, uint8_t qos) {
         if (mqttClient.connected()) {
             if (mqttClient.subscribe(topic, qos)) {
                 subscriptions.push_back(std::make_pair(String(topic), qos));
-                logger.log("MQTTManager", Logger::Level::INFO, "Subscribed to topic: %s", topic);
+                LOGGER_INFO("MQTTManager", "Subscribed to topic: %s", topic);
                 result = true;
             } else {
-                logger.log("MQTTManager", Logger::Level::ERROR, "Failed to subscribe to topic: %s", topic);
+                LOGGER_ERROR("MQTTManager", "Failed to subscribe to topic: %s", topic);
             }
         } else {
-            logger.log("MQTTManager", Logger::Level::ERROR, "Not connected to MQTT broker");
+            LOGGER_ERROR("MQTTManager", "Not connected to MQTT broker");
         }
         xSemaphoreGive(mqttMutex);
     }
@@ -189,12 +784,12 @@ void ESPMQTTManager::setCallback(MQTT_CALLBACK_SIGNATURE) {
         mqttClient.setCallback(callback);
         xSemaphoreGive(mqttMutex);
     }
-    logger.log("MQTTManager", Logger::Level::INFO, "MQTT callback set");
+    LOGGER_INFO("MQTTManager", "MQTT callback set");
 }
 
 void ESPMQTTManager::setAuthMode(AuthMode mode) {
     config.authMode = mode;
-    logger.log("MQTTManager", Logger::Level::INFO, "Authentication mode updated");
+    LOGGER_INFO("MQTTManager", "Authentication mode updated");
 }
 
 PubSubClient& ESPMQTTManager::getClient() {
@@ -204,9 +799,9 @@ PubSubClient& ESPMQTTManager::getClient() {
 void ESPMQTTManager::resubscribe() {
     for (const auto& sub : subscriptions) {
         if (mqttClient.subscribe(sub.first.c_str(), sub.second)) {
-            logger.log("MQTTManager", Logger::Level::INFO, "Resubscribed to topic: %s", sub.first.c_str());
+            LOGGER_INFO("MQTTManager", "Resubscribed to topic: %s", sub.first.c_str());
         } else {
-            logger.log("MQTTManager", Logger::Level::ERROR, "Failed to resubscribe to topic: %s", sub.first.c_str());
+            LOGGER_ERROR("MQTTManager", "Failed to resubscribe to topic: %s", sub.first.c_str());
         }
     }
 }
@@ -221,4 +816,106 @@ String ESPMQTTManager::getClientId() const {
     return (config.clientID && strcmp(config.clientID, "random") != 0) 
         ? config.clientID 
         : "ESPClient-" + String(random(0xffff), HEX);
-}
\ No newline at end of file
+}
+
+ESPMQTTManager::AckClient::AckClient(WiFiClientSecure& client, ESPMQTTManager& manager)
+    : client(client),
+      manager(manager) {
+    reset();
+}
+
+int ESPMQTTManager::AckClient::connect(IPAddress ip, uint16_t port) {
+    reset();
+    return client.connect(ip, port);
+}
+
+int ESPMQTTManager::AckClient::connect(const char* host, uint16_t port) {
+    reset();
+    return client.connect(host, port);
+}
+
+size_t ESPMQTTManager::AckClient::write(uint8_t c) {
+    return client.write(c);
+}
+
+size_t ESPMQTTManager::AckClient::write(const uint8_t* buffer, size_t size) {
+    return client.write(buffer, size);
+}
+
+int ESPMQTTManager::AckClient::available() {
+    return client.available();
+}
+
+int ESPMQTTManager::AckClient::read() {
+    int c = client.read();
+    if (c >= 0) {
+        track(static_cast<uint8_t>(c));
+    }
+    return c;
+}
+
+int ESPMQTTManager::AckClient::read(uint8_t* buffer, size_t size) {
+    int count = client.read(buffer, size);
+    for (int i = 0; i < count; ++i) {
+        track(buffer[i]);
+    }
+    return count;
+}
+
+int ESPMQTTManager::AckClient::peek() {
+    return client.peek();
+}
+
+void ESPMQTTManager::AckClient::flush() {
+    client.flush();
+}
+
+void ESPMQTTManager::AckClient::stop() {
+    client.stop();
+    reset();
+}
+
+uint8_t ESPMQTTManager::AckClient::connected() {
+    return client.connected();
+}
+
+ESPMQTTManager::AckClient::operator bool() {
+    return static_cast<bool>(client);
+}
+
+void ESPMQTTManager::AckClient::reset() {
+    stage = Stage::HEADER;
+    packetType = 0;
+    lengthShift = 0;
+    remaining = 0;
+    packetId = 0;
+}
+
+void ESPMQTTManager::AckClient::track(uint8_t byte) {
+    // Follows the MQTT framing of everything PubSubClient reads; PUBACK carries only the packet id
+    switch (stage) {
+        case Stage::HEADER:
+            packetType = byte >> 4;
+            lengthShift = 0;
+            remaining = 0;
+            packetId = 0;
+            stage = Stage::LENGTH;
+            break;
+        case Stage::LENGTH:
+            remaining |= static_cast<uint32_t>(byte & 0x7F) << lengthShift;
+            lengthShift += 7;
+            if ((byte & 0x80) == 0) {
+                stage = remaining > 0 ? Stage::BODY : Stage::HEADER;
+            }
+            break;
+        case Stage::BODY:
+            packetId = static_cast<uint16_t>(packetId << 8 | byte);
+            if (--remaining == 0) {
+                if (packetType == MQTT_PUBACK_TYPE && lengthShift == 7) {
+                    manager.acknowledge(packetId);
+                }
+                stage = Stage::HEADER;
+            }
+            break;
+    }
+}
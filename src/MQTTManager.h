@@ -6,9 +6,33 @@
  * featuring TLS support, asynchronous operation, automatic reconnection,
  * and a publish buffer for handling network instabilities.
  *
- * @todo Implement support for different MQTT QoS levels
+ * Publishes made while offline are copied into a fixed arena of
+ * publishArenaSize bytes (topic and payload stored contiguously) and
+ * described by trivially copyable PublishItem entries in a fixed ring, so
+ * buffering a message never allocates.
+ *
+ * QoS 1 publishes always go through the arena and stay there until the
+ * broker's PUBACK arrives. Up to inflightWindow of them are on the wire at
+ * once; after a reconnect, or when the oldest one waits longer than
+ * ackTimeout, the unacknowledged ones are sent again with the DUP flag.
+ * PubSubClient ignores PUBACK, so the manager hands it an AckClient that
+ * forwards to the TLS client and watches the inbound packets.
+ *
+ * With Config::spool set, publishes that do not fit in the arena go to an
+ * ESPMQTTSpool on flash instead, and so does everything after them until
+ * the spool is empty, which keeps the order. Once connected, the task
+ * moves spooled messages back into the arena at spoolDrainRate per second.
+ * The spool is committed up to the oldest spooled message not yet
+ * delivered whenever that frees a segment, every spoolCommitInterval ms and
+ * once it is drained; messages delivered but not yet committed are sent
+ * again after a reboot.
+ *
+ * The background task sleeps until there is work: a queued publish, data on
+ * the socket, the keepalive check or the reconnect timer. Failed connection
+ * attempts back off exponentially from reconnectInterval up to
+ * maxReconnectInterval.
+ *
  * @todo Add support for MQTT will messages
- * @todo Consider adding message persistence across power cycles or crashes
  * @todo Evaluate and improve scalability for large number of topics or high message throughput
  * @todo Enhance error handling and recovery mechanisms
  */
@@ -19,13 +43,15 @@
 #include <PubSubClient.h>
 #include <WiFiClientSecure.h>
 #include "ESPLogger.h"
+#include "MQTTSpool.h"
 #include <vector>
 #include <queue>
+#include <type_traits>
 #include <utility>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
-#include "freertos/queue.h"
+#include "freertos/timers.h"
 
 /**
  * @class ESPMQTTManager
@@ -55,22 +81,53 @@ public:
         const char* clientCert;       /**< Client certificate for TLS */
         const char* clientKey;        /**< Client key for TLS */
         const char* clientID;         /**< Client ID for MQTT connection */
-        uint32_t reconnectInterval = 5000;   /**< Interval between reconnection attempts in ms */
+        uint32_t reconnectInterval = 5000;   /**< Delay after the first failed connection attempt in ms */
+        uint32_t maxReconnectInterval = 60000; /**< Upper bound of the doubling reconnect delay in ms */
+        uint32_t pollInterval = 50;          /**< Longest socket wait before queued publishes are checked in ms */
         uint32_t publishTimeout = 1000;      /**< Timeout for publish operations in ms */
         uint16_t maxRetries = 5;             /**< Maximum number of reconnection attempts */
         AuthMode authMode = AuthMode::TLS_USER_PASS_AUTH;  /**< Authentication mode */
-        size_t publishBufferSize = 5;        /**< Size of the publish buffer queue */
+        size_t publishBufferSize = 16;       /**< Maximum number of buffered publishes */
+        size_t publishArenaSize = 4096;      /**< Bytes reserved for buffered topics and payloads */
+        uint8_t inflightWindow = 8;          /**< QoS 1 publishes sent before waiting for a PUBACK */
+        uint32_t ackTimeout = 10000;         /**< Reconnect and resend when a PUBACK is this late, in ms */
+        ESPMQTTSpool* spool = nullptr;       /**< Optional flash queue taking what the arena cannot; call its begin() first */
+        uint16_t spoolDrainRate = 20;        /**< Spooled messages moved back per second once connected, 0 for no limit */
+        uint32_t spoolCommitInterval = 5000; /**< Longest time in ms between spool commits while draining */
+    };
+
+    /**
+     * @enum PublishState
+     * @brief Progress of a buffered publish.
+     */
+    enum class PublishState : uint8_t {
+        QUEUED,     /**< Waiting to be sent */
+        IN_FLIGHT,  /**< QoS 1 publish sent, waiting for its PUBACK */
+        DONE        /**< Sent at QoS 0 or acknowledged; freed once it reaches the front */
     };
 
     /**
      * @struct PublishItem
-     * @brief Structure representing an item in the publish buffer.
+     * @brief Describes a buffered publish stored in the publish arena.
+     *
+     * The arena holds the topic, its terminator and the payload back to back
+     * starting at offset.
      */
     struct PublishItem {
-        String topic;    /**< The topic to publish to */
-        String payload;  /**< The message payload */
-        bool retained;   /**< Whether the message should be retained by the broker */
+        uint32_t offset;         /**< Start of the topic in the publish arena */
+        uint32_t payloadLength;  /**< Payload length in bytes */
+        TickType_t sentAt;       /**< Tick count of the latest transmission */
+        uint16_t topicLength;    /**< Topic length, excluding its terminator */
+        uint16_t packetId;       /**< MQTT packet identifier, 0 until a QoS 1 publish is first sent */
+        bool retained;           /**< Whether the message should be retained by the broker */
+        uint8_t qos;             /**< 0 or 1 */
+        bool dup;                /**< Set once the publish has to be sent again */
+        bool spooled;            /**< Moved back from the flash spool */
+        PublishState state;      /**< Progress of the publish */
+        uint32_t spoolSegment;   /**< Spool segment the message was read from */
+        uint32_t spoolOffset;    /**< Spool offset the message was read from */
     };
+    static_assert(std::is_trivially_copyable<PublishItem>::value, "PublishItem must stay a plain descriptor");
 
     /**
      * @brief Constructor for the ESPMQTTManager.
@@ -99,9 +156,90 @@ public:
      * @param topic The topic to publish to.
      * @param payload The message payload.
      * @param retained Whether the message should be retained by the broker.
+     * @param qos 0, or 1 to keep the message until the broker acknowledges it.
+     * @return true if the publish operation was successful or queued, false otherwise.
+     */
+    bool publish(const char* topic, const char* payload, bool retained = false, uint8_t qos = 0);
+
+    /**
+     * @brief Publishes a binary payload to a specified topic.
+     * @param topic The topic to publish to.
+     * @param payload The message payload.
+     * @param length Payload length in bytes.
+     * @param retained Whether the message should be retained by the broker.
+     * @param qos 0, or 1 to keep the message until the broker acknowledges it.
      * @return true if the publish operation was successful or queued, false otherwise.
      */
-    bool publish(const char* topic, const char* payload, bool retained = false);
+    bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained = false, uint8_t qos = 0);
+
+    /**
+     * @class PublishWriter
+     * @brief Print target that streams one publish of a known length.
+     *
+     * When connected, a QoS 0 payload goes to the socket in
+     * STREAM_CHUNK_SIZE pieces while the writer holds the client; offline
+     * and QoS 1 payloads are written straight into the publish arena, or
+     * into the spool when the arena is full. Obtain one from beginPublish(), write
+     * exactly the announced number of bytes and call end(), which the
+     * destructor also does. Do not call other ESPMQTTManager methods while a
+     * writer is open.
+     */
+    class PublishWriter : public Print {
+    public:
+        static constexpr size_t STREAM_CHUNK_SIZE = 128; ///< Bytes gathered before each socket write
+
+        ~PublishWriter();
+        PublishWriter(const PublishWriter&) = delete;
+        PublishWriter& operator=(const PublishWriter&) = delete;
+
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t* buffer, size_t size) override;
+        using Print::write;
+
+        /**
+         * @brief Completes the publish, or queues it when offline.
+         * @return true if exactly the announced length was written and the message was sent or queued.
+         */
+        bool end();
+
+        /**
+         * @brief Whether the writer accepts data, i.e. beginPublish() found room to send or queue the message.
+         */
+        explicit operator bool() const { return target != Target::NONE && !failed; }
+
+    private:
+        friend class ESPMQTTManager;
+
+        enum class Target { NONE, SOCKET, ARENA, SPOOL };
+
+        PublishWriter(ESPMQTTManager& manager, const char* topic, size_t length, bool retained, uint8_t qos);
+        bool flushChunk();
+
+        ESPMQTTManager& manager;
+        Target target;
+        size_t length;
+        size_t written;
+        bool failed;
+        bool overflowed;
+        PublishItem item;
+        uint8_t chunk[STREAM_CHUNK_SIZE];
+        size_t chunkLength;
+    };
+
+    /**
+     * @brief Starts a streaming publish, e.g. serializeJson(doc, writer) after beginPublish(topic, measureJson(doc)).
+     * @param topic The topic to publish to.
+     * @param length Exact payload length in bytes.
+     * @param retained Whether the message should be retained by the broker.
+     * @param qos 0, or 1 to keep the message until the broker acknowledges it.
+     * @return Writer for the payload; false when converted to bool if the message can neither be sent nor queued.
+     */
+    PublishWriter beginPublish(const char* topic, size_t length, bool retained = false, uint8_t qos = 0);
+
+    /**
+     * @brief Number of buffered publishes not yet sent, or sent at QoS 1 and not yet acknowledged.
+     */
+    size_t getPendingPublishCount();
 
     /**
      * @brief Subscribes to a specified topic.
@@ -136,6 +274,43 @@ public:
     PubSubClient& getClient();
 
 private:
+    /**
+     * @class AckClient
+     * @brief Client handed to PubSubClient that forwards to the TLS client
+     * and reports every inbound PUBACK to the manager.
+     */
+    class AckClient : public Client {
+    public:
+        AckClient(WiFiClientSecure& client, ESPMQTTManager& manager);
+
+        int connect(IPAddress ip, uint16_t port) override;
+        int connect(const char* host, uint16_t port) override;
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t* buffer, size_t size) override;
+        int available() override;
+        int read() override;
+        int read(uint8_t* buffer, size_t size) override;
+        int peek() override;
+        void flush() override;
+        void stop() override;
+        uint8_t connected() override;
+        operator bool() override;
+
+    private:
+        enum class Stage { HEADER, LENGTH, BODY };
+
+        void reset();
+        void track(uint8_t byte);
+
+        WiFiClientSecure& client;
+        ESPMQTTManager& manager;
+        Stage stage;
+        uint8_t packetType;
+        uint8_t lengthShift;
+        uint32_t remaining;
+        uint16_t packetId;
+    };
+
     static void taskWrapper(void* pvParameters);
     void task();
     bool connect();
@@ -144,17 +319,58 @@ private:
     void setupTLS();
     String getClientId() const;
     void processPublishBuffer();
+    bool enqueuePublish(const char* topic, const uint8_t* payload, size_t length, bool retained, uint8_t qos,
+                        const ESPMQTTSpool::Message* source = nullptr);
+    bool beginArenaRecord(const char* topic, size_t length, bool retained, uint8_t qos,
+                          const ESPMQTTSpool::Message* source, PublishItem& item);
+    bool fitsArena(const char* topic, size_t length);
+    bool spooling();
+    void drainSpool();
+    void commitSpool();
+    void endArenaRecord(const PublishItem& item, bool keep);
+    char* arenaPayload(const PublishItem& item);
+    bool reserveArena(size_t size, size_t& offset) const;
+    PublishItem& itemAt(size_t index);
+    bool nextToSend(PublishItem& item, size_t& index);
+    void markSent(size_t index);
+    void releaseDone();
+    void acknowledge(uint16_t packetId);
+    void requeueInFlight();
+    bool ackOverdue();
+    bool sendQos1(const PublishItem& item);
+    bool attemptConnect();
+    uint32_t reconnectDelay() const;
+    bool service();
+    void waitForEvents(bool connected);
+    bool waitForSocket(TickType_t timeout);
+    void notify(uint32_t events);
+    static void reconnectTimerCallback(TimerHandle_t timer);
 
-    Logger& logger;
     Config config;
     WiFiClientSecure espClient;
+    AckClient ackClient;
     PubSubClient mqttClient;
-    TaskHandle_t taskHandle;
+    volatile TaskHandle_t taskHandle;
     SemaphoreHandle_t mqttMutex;
     std::vector<std::pair<String, uint8_t>> subscriptions;
     volatile bool running;
     uint16_t retryCount;
-    QueueHandle_t publishBuffer;
+    TimerHandle_t reconnectTimer;
+    SemaphoreHandle_t arenaMutex;
+    std::vector<char> publishArena;
+    size_t arenaHead;
+    size_t arenaTail;
+    std::vector<PublishItem> publishItems;
+    size_t itemFront;
+    size_t itemCount;
+    size_t sendIndex;
+    size_t inFlightCount;
+    uint16_t nextPacketId;
+    bool spoolUncommitted;
+    uint32_t spoolReadSegment;
+    uint32_t spoolCommittedSegment;
+    TickType_t spoolCommittedAt;
+    TickType_t spoolDrainedAt;
 };
 
 #endif // ESP_MQTT_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,396 @@
+#include "MQTTSpool.h"
+#include "ESPCrc32.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MQTTSpool {
+
+void segmentPath(char* path, size_t size, const char* directory, uint32_t segment) {
+    snprintf(path, size, "%s/seg%u.bin", directory, static_cast<unsigned>(segment));
+}
+
+} // namespace MQTTSpool
+
+namespace {
+
+/**
+ * @brief Get the size of a file.
+ * @param path File path.
+ * @return Size in bytes, or -1 if the file does not exist.
+ */
+long fileSize(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? static_cast<long>(info.st_size) : -1;
+}
+
+} // namespace
+
+ESPMQTTSpool::ESPMQTTSpool(const Config& config)
+    : config(config),
+      firstSegment(0),
+      writeSegment(0),
+      writeSize(0),
+      writeFile(nullptr),
+      writeExpected(0),
+      readSegment(0),
+      readOffset(0),
+      peekedSize(0),
+      readFile(nullptr),
+      corruptRecords(0),
+      started(false) {}
+
+ESPMQTTSpool::~ESPMQTTSpool() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closeReader();
+    if (writeFile != nullptr) {
+        fclose(writeFile);
+        writeFile = nullptr;
+    }
+}
+
+bool ESPMQTTSpool::begin() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (mkdir(config.directory, 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+    DIR* directory = opendir(config.directory);
+    if (directory == nullptr) {
+        return false;
+    }
+
+    bool found = false;
+    uint32_t lowest = 0;
+    uint32_t highest = 0;
+    while (dirent* entry = readdir(directory)) {
+        unsigned segment = 0;
+        int length = 0;
+        if (sscanf(entry->d_name, "seg%u.bin%n", &segment, &length) == 1 && entry->d_name[length] == '\0') {
+            lowest = found ? std::min<uint32_t>(lowest, segment) : segment;
+            highest = found ? std::max<uint32_t>(highest, segment) : segment;
+            found = true;
+        }
+    }
+    closedir(directory);
+
+    // A torn record may end the newest segment, so appends never continue an old one
+    firstSegment = lowest;
+    writeSegment = found ? highest + 1 : 0;
+    writeSize = 0;
+    readSegment = firstSegment;
+    readOffset = 0;
+
+    char path[96];
+    snprintf(path, sizeof(path), "%s/head.bin", config.directory);
+    if (FILE* file = fopen(path, "rb")) {
+        MQTTSpool::Position position;
+        if (fread(&position, 1, sizeof(position), file) == sizeof(position) &&
+            position.magic == MQTTSpool::POSITION_MAGIC &&
+            position.crc == crc32(&position, offsetof(MQTTSpool::Position, crc)) &&
+            position.segment >= firstSegment && position.segment <= writeSegment) {
+            readSegment = position.segment;
+            readOffset = position.offset;
+        }
+        fclose(file);
+    }
+
+    // Skip segments that were read completely before the reset
+    while (readSegment < writeSegment) {
+        MQTTSpool::segmentPath(path, sizeof(path), config.directory, readSegment);
+        long size = fileSize(path);
+        if (size >= 0 && readOffset < static_cast<unsigned long>(size)) {
+            break;
+        }
+        ++readSegment;
+        readOffset = 0;
+    }
+    for (; firstSegment < readSegment; ++firstSegment) {
+        MQTTSpool::segmentPath(path, sizeof(path), config.directory, firstSegment);
+        remove(path);
+    }
+
+    started = true;
+    return true;
+}
+
+bool ESPMQTTSpool::append(const char* topic, const uint8_t* payload, size_t length, bool retained, uint8_t qos) {
+    if (!beginAppend(topic, length, retained, qos)) {
+        return false;
+    }
+    appendData(payload, length);
+    return endAppend(true);
+}
+
+bool ESPMQTTSpool::beginAppend(const char* topic, size_t length, bool retained, uint8_t qos) {
+    const size_t topicLength = strlen(topic);
+    if (topicLength > UINT16_MAX || length > UINT32_MAX - sizeof(MQTTSpool::RecordHeader) - topicLength) {
+        return false;
+    }
+
+    // On success the lock stays held until endAppend
+    mutex.lock();
+    const size_t recordSize = sizeof(MQTTSpool::RecordHeader) + topicLength + length;
+    if (!started || !openWriteSegment(recordSize)) {
+        mutex.unlock();
+        return false;
+    }
+
+    MQTTSpool::RecordHeader header = {};
+    header.magic = MQTTSpool::RECORD_MAGIC;
+    header.topicLength = static_cast<uint16_t>(topicLength);
+    header.flags = (retained ? MQTTSpool::FLAG_RETAINED : 0) | (qos > 0 ? MQTTSpool::FLAG_QOS1 : 0);
+    header.version = MQTTSpool::FORMAT_VERSION;
+    header.payloadLength = static_cast<uint32_t>(length);
+
+    const uint8_t* headerBytes = reinterpret_cast<const uint8_t*>(&header);
+    writeBuffer.reserve(recordSize);
+    writeBuffer.assign(headerBytes, headerBytes + sizeof(header));
+    writeBuffer.insert(writeBuffer.end(), topic, topic + topicLength);
+    writeExpected = recordSize;
+    return true;
+}
+
+void ESPMQTTSpool::appendData(const uint8_t* data, size_t size) {
+    writeBuffer.insert(writeBuffer.end(), data, data + size);
+}
+
+bool ESPMQTTSpool::endAppend(bool keep) {
+    const bool kept = keep && writeBuffer.size() == writeExpected && writeRecord();
+    writeBuffer.clear();
+    mutex.unlock();
+    return kept;
+}
+
+bool ESPMQTTSpool::peek(Message& message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return started && readRecord(message);
+}
+
+void ESPMQTTSpool::consume() {
+    std::lock_guard<std::mutex> lock(mutex);
+    readOffset += peekedSize;
+    peekedSize = 0;
+
+    // Step past a segment read to its end now, so empty() and commit() treat it as read without another peek()
+    struct stat info;
+    if (readSegment < writeSegment && readFile != nullptr && fstat(fileno(readFile), &info) == 0 &&
+        readOffset >= static_cast<size_t>(info.st_size)) {
+        closeReader();
+        ++readSegment;
+        readOffset = 0;
+    }
+}
+
+bool ESPMQTTSpool::commit() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!started) {
+        return false;
+    }
+
+    // Once everything is read, retire the current segment too instead of appending behind the cursor
+    if (readSegment == writeSegment && writeSize > 0 && readOffset >= writeSize) {
+        closeReader();
+        if (writeFile != nullptr) {
+            fclose(writeFile);
+            writeFile = nullptr;
+        }
+        ++writeSegment;
+        writeSize = 0;
+        readSegment = writeSegment;
+        readOffset = 0;
+    }
+
+    return trimTo(readSegment, readOffset);
+}
+
+bool ESPMQTTSpool::commit(uint32_t segment, uint32_t offset) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!started || segment < firstSegment) {
+        return false;
+    }
+
+    // Never persist more than has been read
+    if (segment > readSegment || (segment == readSegment && offset > readOffset)) {
+        segment = readSegment;
+        offset = readOffset;
+    }
+    return trimTo(segment, offset);
+}
+
+bool ESPMQTTSpool::empty() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return emptyLocked();
+}
+
+size_t ESPMQTTSpool::getCorruptRecordCount() const {
+    return corruptRecords;
+}
+
+bool ESPMQTTSpool::openWriteSegment(size_t recordSize) {
+    if (writeFile != nullptr && writeSize > 0 && writeSize + recordSize > config.segmentSize) {
+        fclose(writeFile);
+        writeFile = nullptr;
+        ++writeSegment;
+        writeSize = 0;
+    }
+    if (writeFile != nullptr) {
+        return true;
+    }
+
+    if (writeSegment - firstSegment + 1 > config.maxSegments) {
+        return false;
+    }
+    char path[96];
+    MQTTSpool::segmentPath(path, sizeof(path), config.directory, writeSegment);
+    writeFile = fopen(path, "ab");
+    if (writeFile == nullptr) {
+        return false;
+    }
+    fseek(writeFile, 0, SEEK_END);
+    long position = ftell(writeFile);
+    writeSize = position > 0 ? static_cast<size_t>(position) : 0;
+    return true;
+}
+
+bool ESPMQTTSpool::writeRecord() {
+    MQTTSpool::RecordHeader header;
+    memcpy(&header, writeBuffer.data(), sizeof(header));
+    header.crc = crc32(writeBuffer.data() + sizeof(header), writeBuffer.size() - sizeof(header));
+    memcpy(writeBuffer.data(), &header, sizeof(header));
+
+    bool written = fwrite(writeBuffer.data(), 1, writeBuffer.size(), writeFile) == writeBuffer.size() &&
+                   fflush(writeFile) == 0 && fsync(fileno(writeFile)) == 0;
+    if (written) {
+        writeSize += writeBuffer.size();
+    } else {
+        // Part of the record may have reached the file, so continue in a fresh segment
+        fclose(writeFile);
+        writeFile = nullptr;
+        ++writeSegment;
+        writeSize = 0;
+    }
+    return written;
+}
+
+bool ESPMQTTSpool::readRecord(Message& message) {
+    char path[96];
+    while (!emptyLocked()) {
+        if (readFile == nullptr) {
+            MQTTSpool::segmentPath(path, sizeof(path), config.directory, readSegment);
+            readFile = fopen(path, "rb");
+        }
+
+        MQTTSpool::RecordHeader header;
+        if (readFile == nullptr || fseek(readFile, readOffset, SEEK_SET) != 0 ||
+            fread(&header, 1, sizeof(header), readFile) != sizeof(header)) {
+            // End of the segment; the one being written is reopened later to see new records
+            closeReader();
+            if (readSegment == writeSegment) {
+                return false;
+            }
+            ++readSegment;
+            readOffset = 0;
+            continue;
+        }
+
+        struct stat info;
+        const size_t recordSize = sizeof(header) + header.topicLength + static_cast<size_t>(header.payloadLength);
+        bool valid = header.magic == MQTTSpool::RECORD_MAGIC && header.version == MQTTSpool::FORMAT_VERSION &&
+                     fstat(fileno(readFile), &info) == 0 && readOffset + recordSize <= static_cast<size_t>(info.st_size);
+        if (valid) {
+            // Topic, terminator, payload
+            readBuffer.resize(header.topicLength + 1 + header.payloadLength);
+            valid = fread(readBuffer.data(), 1, header.topicLength, readFile) == header.topicLength &&
+                    fread(readBuffer.data() + header.topicLength + 1, 1, header.payloadLength, readFile) == header.payloadLength;
+        }
+        if (valid) {
+            uint32_t crc = crc32(readBuffer.data(), header.topicLength);
+            valid = crc32(readBuffer.data() + header.topicLength + 1, header.payloadLength, crc) == header.crc;
+        }
+        if (!valid) {
+            // A torn or unknown record leaves no reliable way to find the next one in this segment
+            ++corruptRecords;
+            closeReader();
+            if (readSegment == writeSegment && writeFile != nullptr) {
+                fclose(writeFile);
+                writeFile = nullptr;
+                ++writeSegment;
+                writeSize = 0;
+            }
+            ++readSegment;
+            readOffset = 0;
+            continue;
+        }
+
+        readBuffer[header.topicLength] = '\0';
+        message.topic = reinterpret_cast<const char*>(readBuffer.data());
+        message.payload = readBuffer.data() + header.topicLength + 1;
+        message.length = header.payloadLength;
+        message.retained = (header.flags & MQTTSpool::FLAG_RETAINED) != 0;
+        message.qos = (header.flags & MQTTSpool::FLAG_QOS1) != 0 ? 1 : 0;
+        message.segment = readSegment;
+        message.offset = readOffset;
+        peekedSize = static_cast<uint32_t>(recordSize);
+        return true;
+    }
+    return false;
+}
+
+void ESPMQTTSpool::closeReader() {
+    if (readFile != nullptr) {
+        fclose(readFile);
+        readFile = nullptr;
+    }
+}
+
+bool ESPMQTTSpool::trimTo(uint32_t segment, uint32_t offset) {
+    // Save first: a reset before the deletes only leaves read segments behind, which begin() removes
+    if (!savePosition(segment, offset)) {
+        return false;
+    }
+    char path[96];
+    for (; firstSegment < segment; ++firstSegment) {
+        MQTTSpool::segmentPath(path, sizeof(path), config.directory, firstSegment);
+        remove(path);
+    }
+    return true;
+}
+
+bool ESPMQTTSpool::savePosition(uint32_t segment, uint32_t offset) {
+    MQTTSpool::Position position;
+    position.magic = MQTTSpool::POSITION_MAGIC;
+    position.segment = segment;
+    position.offset = offset;
+    position.crc = crc32(&position, offsetof(MQTTSpool::Position, crc));
+
+    // Write a temporary file and rename it, so a reset never leaves a half-written position
+    char temporary[96];
+    char path[96];
+    snprintf(temporary, sizeof(temporary), "%s/head.tmp", config.directory);
+    snprintf(path, sizeof(path), "%s/head.bin", config.directory);
+    FILE* file = fopen(temporary, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(&position, 1, sizeof(position), file) == sizeof(position) && fflush(file) == 0 &&
+                   fsync(fileno(file)) == 0;
+    fclose(file);
+    if (!written) {
+        return false;
+    }
+    if (rename(temporary, path) != 0) {
+        // Some filesystems do not replace an existing file on rename
+        remove(path);
+        return rename(temporary, path) == 0;
+    }
+    return true;
+}
+
+bool ESPMQTTSpool::emptyLocked() const {
+    return readSegment > writeSegment || (readSegment == writeSegment && readOffset >= writeSize);
+}
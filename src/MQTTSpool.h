@@ -0,0 +1,232 @@
+/**
+ * @file MQTTSpool.h
+ * @brief Flash-backed outbound MQTT queue that survives reboots.
+ *
+ * ESPMQTTSpool stores publishes that do not fit in ESPMQTTManager's RAM
+ * buffer in append-only segment files <directory>/seg<N>.bin. A segment is
+ * closed once it reaches segmentSize and a new one is started; at most
+ * maxSegments exist, after which appends are refused. Messages are read
+ * back in order, and the position of the oldest message not yet delivered
+ * is kept in <directory>/head.bin, so after a reboot the queue resumes
+ * there. Fully delivered segments are deleted.
+ *
+ * Files are accessed through stdio and POSIX directory calls only, so on
+ * the ESP32 the directory must be on a mounted VFS (e.g. "/littlefs/mqtt"
+ * after LittleFS.begin()) and on a host any plain directory works.
+ *
+ * File format: a sequence of records, each a RecordHeader followed by the
+ * topic without terminator and the payload. The CRC covers both, so a
+ * record torn by a reset is detected; the rest of that segment is skipped.
+ * Appends after a reboot always start a new segment.
+ */
+
+#ifndef ESP_MQTT_SPOOL_H
+#define ESP_MQTT_SPOOL_H
+
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace MQTTSpool {
+
+static constexpr uint32_t RECORD_MAGIC = 0x5451514D;   ///< "MQQT" in little-endian byte order
+static constexpr uint32_t POSITION_MAGIC = 0x4851514D; ///< "MQQH" in little-endian byte order
+static constexpr uint8_t FORMAT_VERSION = 1;           ///< Version written in every record header
+static constexpr uint8_t FLAG_RETAINED = 0x01;         ///< Record flag: retained message
+static constexpr uint8_t FLAG_QOS1 = 0x02;             ///< Record flag: publish at QoS 1
+
+/**
+ * @struct RecordHeader
+ * @brief Header in front of every stored message.
+ */
+struct RecordHeader {
+    uint32_t magic;          ///< RECORD_MAGIC
+    uint16_t topicLength;    ///< Number of topic bytes
+    uint8_t flags;           ///< FLAG_RETAINED and FLAG_QOS1
+    uint8_t version;         ///< FORMAT_VERSION
+    uint32_t payloadLength;  ///< Number of payload bytes after the topic
+    uint32_t crc;            ///< CRC-32 of the topic and payload
+};
+
+/**
+ * @struct Position
+ * @brief Contents of head.bin: where the oldest undelivered message starts.
+ */
+struct Position {
+    uint32_t magic;    ///< POSITION_MAGIC
+    uint32_t segment;  ///< Segment number
+    uint32_t offset;   ///< Byte offset inside the segment
+    uint32_t crc;      ///< CRC-32 of the fields above
+};
+
+static_assert(sizeof(RecordHeader) == 16, "Record header layout is part of the file format");
+static_assert(sizeof(Position) == 16, "Position layout is part of the file format");
+
+/**
+ * @brief Build the path of a segment file.
+ * @param path Destination buffer.
+ * @param size Size of the destination buffer.
+ * @param directory Spool directory.
+ * @param segment Segment number.
+ */
+void segmentPath(char* path, size_t size, const char* directory, uint32_t segment);
+
+} // namespace MQTTSpool
+
+/**
+ * @class ESPMQTTSpool
+ * @brief Persistent FIFO of outbound MQTT messages in segment files.
+ *
+ * Reading is two-step: peek() and consume() move a cursor in RAM while the
+ * messages are handed to the MQTT client, and commit() persists that
+ * cursor once they have been delivered, or the position of the oldest
+ * message still undelivered. Anything not committed is read again after a
+ * reboot.
+ */
+class ESPMQTTSpool {
+public:
+    /**
+     * @struct Config
+     * @brief Configuration of the spool.
+     */
+    struct Config {
+        const char* directory = "/littlefs/mqtt"; /**< Directory holding the segment files */
+        size_t segmentSize = 16 * 1024;  /**< Size in bytes at which a segment is closed */
+        size_t maxSegments = 8;          /**< Segments kept before appends are refused */
+    };
+
+    /**
+     * @struct Message
+     * @brief A stored message returned by peek().
+     */
+    struct Message {
+        const char* topic;       /**< Null-terminated topic */
+        const uint8_t* payload;  /**< Payload bytes */
+        size_t length;           /**< Payload length in bytes */
+        bool retained;           /**< Whether the message should be retained by the broker */
+        uint8_t qos;             /**< 0 or 1 */
+        uint32_t segment;        /**< Segment holding the message, for commit(segment, offset) */
+        uint32_t offset;         /**< Offset of the message inside its segment */
+    };
+
+    /**
+     * @brief Constructor for the spool.
+     * @param config The configuration of the spool.
+     */
+    explicit ESPMQTTSpool(const Config& config);
+
+    /**
+     * @brief Destructor, closes the open files.
+     */
+    ~ESPMQTTSpool();
+
+    /**
+     * @brief Create the directory, find the stored segments and load the saved position.
+     * @return true if the directory is usable.
+     */
+    bool begin();
+
+    /**
+     * @brief Store one message.
+     * @param topic The topic to publish to.
+     * @param payload The message payload.
+     * @param length Payload length in bytes.
+     * @param retained Whether the message should be retained by the broker.
+     * @param qos 0 or 1.
+     * @return true if the message was written and synced, false if the spool is full or the write failed.
+     */
+    bool append(const char* topic, const uint8_t* payload, size_t length, bool retained, uint8_t qos);
+
+    /**
+     * @brief Start storing a message whose payload is supplied in pieces.
+     *
+     * On success the spool stays locked until endAppend(), which must follow.
+     * @param topic The topic to publish to.
+     * @param length Exact payload length in bytes.
+     * @param retained Whether the message should be retained by the broker.
+     * @param qos 0 or 1.
+     * @return true if there is room for the message.
+     */
+    bool beginAppend(const char* topic, size_t length, bool retained, uint8_t qos);
+
+    /**
+     * @brief Add payload bytes to the message started with beginAppend().
+     * @param data Bytes to add.
+     * @param size Number of bytes.
+     */
+    void appendData(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Finish the message started with beginAppend().
+     * @param keep false to drop the message, e.g. when fewer bytes than announced arrived.
+     * @return true if the message was kept, written and synced.
+     */
+    bool endAppend(bool keep);
+
+    /**
+     * @brief Read the next message without consuming it.
+     * @param message Filled with pointers that stay valid until the next peek().
+     * @return true if a message was read, false if there is none.
+     */
+    bool peek(Message& message);
+
+    /**
+     * @brief Move past the message returned by the last peek().
+     */
+    void consume();
+
+    /**
+     * @brief Persist the read position and delete segments that were read completely.
+     * @return true if the position was saved.
+     */
+    bool commit();
+
+    /**
+     * @brief Persist an earlier position, e.g. that of the oldest message not yet delivered.
+     *
+     * Segments before it are deleted; the read cursor is not moved.
+     * @param segment Segment of the position, as returned in Message::segment.
+     * @param offset Offset of the position, as returned in Message::offset.
+     * @return true if the position was saved.
+     */
+    bool commit(uint32_t segment, uint32_t offset);
+
+    /**
+     * @brief Whether every stored message has been consumed.
+     */
+    bool empty();
+
+    /**
+     * @brief Get the number of damaged records found so far.
+     * @return Number of records with a bad header or CRC.
+     */
+    size_t getCorruptRecordCount() const;
+
+private:
+    bool openWriteSegment(size_t recordSize);
+    bool writeRecord();
+    bool readRecord(Message& message);
+    void closeReader();
+    bool savePosition(uint32_t segment, uint32_t offset);
+    bool trimTo(uint32_t segment, uint32_t offset);
+    bool emptyLocked() const;
+
+    Config config;
+    std::mutex mutex;
+    uint32_t firstSegment;
+    uint32_t writeSegment;
+    size_t writeSize;
+    FILE* writeFile;
+    std::vector<uint8_t> writeBuffer;
+    size_t writeExpected;
+    uint32_t readSegment;
+    uint32_t readOffset;
+    uint32_t peekedSize;
+    FILE* readFile;
+    std::vector<uint8_t> readBuffer;
+    size_t corruptRecords;
+    bool started;
+};
+
+#endif // ESP_MQTT_SPOOL_H
@@ -0,0 +1,116 @@
+/**
+ * @file logdecode.cpp
+ * @brief Host tool turning LogWire binary dumps back into text or NDJSON.
+ *
+ * Build from the repository root with any C++17 compiler:
+ *
+ *   g++ -std=c++17 -O2 -Isrc -o logdecode tools/logdecode/logdecode.cpp src/ESPLogWire.cpp src/ESPLogFormat.cpp
+ *
+ * Usage: logdecode [--json] [file]   (reads standard input without a file)
+ *
+ * The dump is any concatenation of buffers filled by Logger::exportBinary,
+ * e.g. MQTT payloads appended to one file.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ESPLogWire.h"
+
+namespace {
+
+const char* levelName(uint8_t level) {
+    static const char* const NAMES[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+    return level < sizeof(NAMES) / sizeof(NAMES[0]) ? NAMES[level] : "UNKNOWN";
+}
+
+void printJsonString(const std::string& text) {
+    putchar('"');
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': fputs("\\\"", stdout); break;
+            case '\\': fputs("\\\\", stdout); break;
+            case '\n': fputs("\\n", stdout); break;
+            case '\r': fputs("\\r", stdout); break;
+            case '\t': fputs("\\t", stdout); break;
+            default:
+                if (c < 0x20) {
+                    printf("\\u%04x", c);
+                } else {
+                    putchar(c);
+                }
+                break;
+        }
+    }
+    putchar('"');
+}
+
+bool readAll(FILE* file, std::vector<uint8_t>& data) {
+    uint8_t chunk[4096];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + count);
+    }
+    return !ferror(file);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool json = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (path == nullptr && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [--json] [file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    FILE* file = path != nullptr ? fopen(path, "rb") : stdin;
+    if (file == nullptr) {
+        perror(path);
+        return 1;
+    }
+    std::vector<uint8_t> data;
+    bool read = readAll(file, data);
+    if (file != stdin) {
+        fclose(file);
+    }
+    if (!read) {
+        fprintf(stderr, "failed to read input\n");
+        return 1;
+    }
+
+    LogWire::Decoder decoder(data.data(), data.size());
+    LogWire::DecodedEntry entry;
+    LogWire::Decoder::Status status;
+    while ((status = decoder.next(entry)) == LogWire::Decoder::Status::ENTRY) {
+        if (json) {
+            // Same fields as Logger::getNextLogJson, plus the sequence number
+            fputs("{\"tag\":", stdout);
+            printJsonString(entry.tagName);
+            printf(",\"level\":%u,\"timestamp_us\":%lld,\"sequence\":%lu,\"message\":", entry.level,
+                   static_cast<long long>(entry.timestamp), static_cast<unsigned long>(entry.sequence));
+            printJsonString(entry.message);
+            fputs("}\n", stdout);
+        } else {
+            if (entry.lost > 0) {
+                printf("... %lu entries lost\n", static_cast<unsigned long>(entry.lost));
+            }
+            printf("%lu %lld.%06lld [%s] %s: %s\n", static_cast<unsigned long>(entry.sequence),
+                   static_cast<long long>(entry.timestamp / 1000000), static_cast<long long>(entry.timestamp % 1000000),
+                   entry.tagName, levelName(entry.level), entry.message.c_str());
+        }
+    }
+
+    if (status == LogWire::Decoder::Status::ERROR) {
+        fprintf(stderr, "corrupt record at offset %zu\n", decoder.offset());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,352 @@
+/**
+ * @file logfiletest.cpp
+ * @brief Host test for ESPLogFileSink and ESPLogFileReader.
+ *
+ * Build and run from the repository root with any C++17 compiler and
+ * ArduinoJson 7 (PlatformIO fetches it into .pio/libdeps), reusing the
+ * loggerbench host shims:
+ *
+ *   g++ -std=gnu++17 -O2 -Itools/loggerbench/host -Isrc -I.pio/libdeps/nodemcu-32s/ArduinoJson/src \
+ *       -include Arduino.h -o logfiletest tools/logfiletest/logfiletest.cpp tools/loggerbench/host/host.cpp \
+ *       src/ESPLogFile.cpp src/ESPLogger.cpp src/ESPLogFormat.cpp src/ESPBraceFormat.cpp -lpthread
+ *   ./logfiletest
+ *
+ * Every case writes into its own directory under the system temp
+ * directory. Failed checks are printed with their line; the exit status is
+ * the number of failed checks.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ESPLogFile.h"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+void check(bool passed, const char* text, int line) {
+    if (!passed) {
+        fprintf(stderr, "logfiletest.cpp:%d: check failed: %s\n", line, text);
+        ++failures;
+    }
+}
+
+/**
+ * @brief Create an empty directory for one case.
+ * @param name Case name, part of the directory name.
+ * @return Path of the directory.
+ */
+std::string makeDirectory(const char* name) {
+    const char* base = getenv("TMPDIR");
+    std::string pattern = std::string(base != nullptr ? base : "/tmp") + "/logfiletest-" + name + "-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+    if (mkdtemp(path.data()) == nullptr) {
+        perror("mkdtemp");
+        exit(1);
+    }
+    return path.data();
+}
+
+std::string filePath(const std::string& directory, size_t index) {
+    char path[256];
+    LogFile::filePath(path, sizeof(path), directory.c_str(), index);
+    return path;
+}
+
+bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+long fileSize(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? static_cast<long>(info.st_size) : -1;
+}
+
+/**
+ * @brief Build the entry a case writes at a given index.
+ * @param index Entry index, also used as timestamp and message number.
+ * @return The entry.
+ */
+Logger::LogEntry makeEntry(int index) {
+    Logger::LogEntry entry = {};
+    snprintf(entry.tag, sizeof(entry.tag), "File%d", index % 3);
+    snprintf(entry.message, sizeof(entry.message), "entry %d with some padding", index);
+    entry.level = static_cast<Logger::Level>(index % 4);
+    entry.timestamp = 1000000 + index * 1000;
+    return entry;
+}
+
+bool sameEntry(const Logger::LogEntry& read, int index) {
+    Logger::LogEntry expected = makeEntry(index);
+    return strcmp(read.tag, expected.tag) == 0 && strcmp(read.message, expected.message) == 0 &&
+           read.level == expected.level && read.timestamp == expected.timestamp;
+}
+
+/**
+ * @brief Write entries [first, last) through a sink, one call per entry, and flush.
+ */
+void writeEntries(const ESPLogFileSink::Config& config, int first, int last) {
+    ESPLogFileSink sink(config);
+    CHECK(sink.begin());
+    for (int i = first; i < last; ++i) {
+        Logger::LogEntry entry = makeEntry(i);
+        sink.write(&entry, 1);
+    }
+    CHECK(sink.flush());
+    CHECK(sink.getWriteErrorCount() == 0);
+}
+
+/**
+ * @brief Read every entry and check they are consecutive.
+ * @param reader Reader to drain.
+ * @param first Set to the index of the first entry read, -1 if none.
+ * @return Number of entries read.
+ */
+int readConsecutive(ESPLogFileReader& reader, int& first) {
+    Logger::LogEntry entry;
+    int count = 0;
+    first = -1;
+    while (reader.next(entry)) {
+        int index = -1;
+        sscanf(entry.message, "entry %d", &index);
+        if (count == 0) {
+            first = index;
+        }
+        CHECK(index == first + count && sameEntry(entry, index));
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * @brief Get the offset of a block in a file written by the sink.
+ * @param path File to scan.
+ * @param block Index of the block.
+ * @return Offset of its header, or -1 past the last block.
+ */
+long blockOffset(const std::string& path, size_t block) {
+    FILE* file = fopen(path.c_str(), "rb");
+    long offset = 0;
+    for (size_t i = 0; file != nullptr && i <= block; ++i) {
+        LogFile::BlockHeader header;
+        if (fseek(file, offset, SEEK_SET) != 0 || fread(&header, 1, sizeof(header), file) != sizeof(header)) {
+            offset = -1;
+            break;
+        }
+        if (i < block) {
+            offset += sizeof(header) + header.payloadLength;
+        }
+    }
+    if (file != nullptr) {
+        fclose(file);
+    }
+    return offset;
+}
+
+void appendBytes(const std::string& path, const void* bytes, size_t length) {
+    FILE* file = fopen(path.c_str(), "ab");
+    CHECK(file != nullptr && fwrite(bytes, 1, length, file) == length);
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+void flipByte(const std::string& path, long offset) {
+    FILE* file = fopen(path.c_str(), "r+b");
+    CHECK(file != nullptr);
+    if (file == nullptr) {
+        return;
+    }
+    fseek(file, offset, SEEK_SET);
+    int value = fgetc(file);
+    fseek(file, offset, SEEK_SET);
+    fputc(value ^ 0x5A, file);
+    fclose(file);
+}
+
+void testRoundTrip() {
+    std::string directory = makeDirectory("roundtrip");
+    ESPLogFileSink::Config config;
+    config.directory = directory.c_str();
+    config.fileCount = 4;
+    config.maxFileSize = 64 * 1024;
+    config.blockSize = 512;
+    writeEntries(config, 0, 100);
+
+    CHECK(fileExists(filePath(directory, 0)));
+    CHECK(!fileExists(filePath(directory, 1)));
+
+    ESPLogFileReader reader(directory.c_str(), config.fileCount);
+    int first;
+    CHECK(readConsecutive(reader, first) == 100 && first == 0);
+    CHECK(reader.getCorruptBlockCount() == 0);
+
+    reader.rewind();
+    Logger::LogEntry entry;
+    CHECK(reader.next(entry) && sameEntry(entry, 0));
+}
+
+void testRotation() {
+    std::string directory = makeDirectory("rotation");
+    ESPLogFileSink::Config config;
+    config.directory = directory.c_str();
+    config.fileCount = 3;
+    config.maxFileSize = 1024;
+    config.blockSize = 256;
+    writeEntries(config, 0, 300);
+
+    for (size_t index = 0; index < config.fileCount; ++index) {
+        CHECK(fileExists(filePath(directory, index)));
+        CHECK(fileSize(filePath(directory, index)) <= static_cast<long>(config.maxFileSize));
+    }
+    CHECK(!fileExists(filePath(directory, config.fileCount)));
+
+    // The oldest files were deleted, so the replay is the newest consecutive run ending at the last entry
+    ESPLogFileReader reader(directory.c_str(), config.fileCount);
+    int first;
+    int count = readConsecutive(reader, first);
+    CHECK(count > 0 && first > 0 && first + count == 300);
+    CHECK(reader.getCorruptBlockCount() == 0);
+
+    // A new sink appends to the current file instead of starting over
+    writeEntries(config, 300, 310);
+    ESPLogFileReader resumed(directory.c_str(), config.fileCount);
+    count = readConsecutive(resumed, first);
+    CHECK(count > 0 && first + count == 310);
+}
+
+void testTornBlock() {
+    std::string directory = makeDirectory("torn");
+    ESPLogFileSink::Config config;
+    config.directory = directory.c_str();
+    config.blockSize = 256;
+    writeEntries(config, 0, 40);
+    std::string path = filePath(directory, 0);
+
+    // A reset during the header write leaves a short header: the file simply ends there
+    LogFile::BlockHeader header = {LogFile::BLOCK_MAGIC, LogFile::FORMAT_VERSION, 3, 200, 0};
+    appendBytes(path, &header, 7);
+    {
+        ESPLogFileReader reader(directory.c_str(), config.fileCount);
+        int first;
+        CHECK(readConsecutive(reader, first) == 40 && first == 0);
+        CHECK(reader.getCorruptBlockCount() == 0);
+    }
+
+    // A reset during the payload write leaves a header whose length runs past the end of the file
+    truncate(path.c_str(), fileSize(path) - 7);
+    uint8_t payload[50] = {};
+    appendBytes(path, &header, sizeof(header));
+    appendBytes(path, payload, sizeof(payload));
+    {
+        ESPLogFileReader reader(directory.c_str(), config.fileCount);
+        int first;
+        CHECK(readConsecutive(reader, first) == 40 && first == 0);
+        CHECK(reader.getCorruptBlockCount() == 1);
+    }
+
+    // A damaged length is rejected before anything is allocated for it
+    truncate(path.c_str(), fileSize(path) - sizeof(header) - sizeof(payload));
+    header.payloadLength = 0xFFFFFFF0;
+    appendBytes(path, &header, sizeof(header));
+    {
+        ESPLogFileReader reader(directory.c_str(), config.fileCount);
+        int first;
+        CHECK(readConsecutive(reader, first) == 40 && first == 0);
+        CHECK(reader.getCorruptBlockCount() == 1);
+    }
+}
+
+void testBadCrc() {
+    std::string directory = makeDirectory("crc");
+    ESPLogFileSink::Config config;
+    config.directory = directory.c_str();
+    config.fileCount = 2;
+    config.maxFileSize = 2048;
+    config.blockSize = 256;
+    writeEntries(config, 0, 60);
+    std::string older = filePath(directory, 1);
+    std::string newer = filePath(directory, 0);
+    CHECK(fileExists(older) && fileExists(newer));
+
+    // Count the entries of the first block of the older file, then damage its second block
+    ESPLogFileReader intact(directory.c_str(), config.fileCount);
+    int first;
+    int total = readConsecutive(intact, first);
+    LogFile::BlockHeader header;
+    FILE* file = fopen(older.c_str(), "rb");
+    CHECK(file != nullptr && fread(&header, 1, sizeof(header), file) == sizeof(header));
+    if (file != nullptr) {
+        fclose(file);
+    }
+    long second = blockOffset(older, 1);
+    CHECK(second > 0);
+    flipByte(older, second + sizeof(LogFile::BlockHeader) + 4);
+
+    // The rest of the damaged file is skipped, the newer file is still read
+    ESPLogFileReader reader(directory.c_str(), config.fileCount);
+    Logger::LogEntry entry;
+    int count = 0;
+    int previous = -1;
+    bool ordered = true;
+    while (reader.next(entry)) {
+        int index = -1;
+        sscanf(entry.message, "entry %d", &index);
+        ordered = ordered && index > previous && sameEntry(entry, index);
+        previous = index;
+        ++count;
+    }
+    CHECK(ordered);
+    CHECK(reader.getCorruptBlockCount() == 1);
+    CHECK(count >= header.entryCount && count < total);
+    CHECK(previous == first + total - 1);
+}
+
+void testIdleFlush() {
+    std::string directory = makeDirectory("idle");
+    ESPLogFileSink::Config config;
+    config.directory = directory.c_str();
+    config.flushInterval = 50;
+    ESPLogFileSink sink(config);
+    CHECK(sink.begin());
+
+    Logger::LogEntry entry = makeEntry(0);
+    sink.write(&entry, 1);
+    sink.idle();
+    CHECK(fileSize(filePath(directory, 0)) == 0);
+
+    // With logging quiet, only idle() runs; it writes the block once flushInterval has passed
+    std::this_thread::sleep_for(std::chrono::milliseconds(config.flushInterval + 20));
+    sink.idle();
+    CHECK(fileSize(filePath(directory, 0)) > 0);
+
+    ESPLogFileReader reader(directory.c_str(), config.fileCount);
+    CHECK(reader.next(entry) && sameEntry(entry, 0));
+    CHECK(!reader.next(entry));
+}
+
+} // namespace
+
+int main() {
+    testRoundTrip();
+    testRotation();
+    testTornBlock();
+    testBadCrc();
+    testIdleFlush();
+
+    if (failures == 0) {
+        printf("logfiletest: all checks passed\n");
+    }
+    return failures;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the parts of the Arduino core the Logger uses.
+ */
+
+#ifndef LOGGERBENCH_ARDUINO_H
+#define LOGGERBENCH_ARDUINO_H
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t written = 0;
+        while (size-- > 0) {
+            written += write(*buffer++);
+        }
+        return written;
+    }
+
+    size_t write(const char* text) { return write(reinterpret_cast<const uint8_t*>(text), strlen(text)); }
+    size_t write(const char* text, size_t size) { return write(reinterpret_cast<const uint8_t*>(text), size); }
+    size_t print(const char* text) { return write(text); }
+
+    size_t printf(const char* format, ...) {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return length > 0 ? write(buffer, std::min(static_cast<size_t>(length), sizeof(buffer) - 1)) : 0;
+    }
+};
+
+/// String backed by std::string; write() lets ArduinoJson serialize into it
+class String : public std::string {
+public:
+    using std::string::string;
+    String() = default;
+
+    bool isEmpty() const { return empty(); }
+
+    size_t write(uint8_t c) {
+        push_back(static_cast<char>(c));
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) {
+        append(reinterpret_cast<const char*>(buffer), size);
+        return size;
+    }
+};
+
+class HostSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+};
+
+extern HostSerial Serial;
+
+#endif // LOGGERBENCH_ARDUINO_H
@@ -0,0 +1,12 @@
+#ifndef LOGGERBENCH_ESP_TIMER_H
+#define LOGGERBENCH_ESP_TIMER_H
+
+#include <chrono>
+#include <cstdint>
+
+inline int64_t esp_timer_get_time() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // LOGGERBENCH_ESP_TIMER_H
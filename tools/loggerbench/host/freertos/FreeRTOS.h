@@ -0,0 +1,48 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS types and port macros the Logger uses.
+ */
+
+#ifndef LOGGERBENCH_FREERTOS_H
+#define LOGGERBENCH_FREERTOS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void*);
+typedef struct HostTask* TaskHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(ms))
+#define portNUM_PROCESSORS 2
+
+/// Core of the calling thread; threads are spread over the cores round-robin
+BaseType_t xPortGetCoreID();
+
+/// Spinlock with the portMUX_TYPE interface; host threads stand in for both cores
+struct portMUX_TYPE {
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+
+inline void portENTER_CRITICAL(portMUX_TYPE* mux) {
+    while (mux->flag.test_and_set(std::memory_order_acquire)) {
+    }
+}
+
+inline void portEXIT_CRITICAL(portMUX_TYPE* mux) {
+    mux->flag.clear(std::memory_order_release);
+}
+
+#endif // LOGGERBENCH_FREERTOS_H
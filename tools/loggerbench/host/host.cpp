@@ -0,0 +1,96 @@
+#include "Arduino.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/// Task control block: a thread plus its notification counter
+struct HostTask {
+    std::mutex mutex;
+    std::condition_variable notified;
+    uint32_t notifications = 0;
+};
+
+HostSerial Serial;
+
+namespace {
+
+struct TaskExit {};
+
+thread_local HostTask* currentTask = nullptr;
+std::atomic<unsigned> threadCount{0};
+thread_local const unsigned threadCore = threadCount.fetch_add(1) % portNUM_PROCESSORS;
+
+} // namespace
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char*, uint32_t, void* parameter, UBaseType_t,
+                                   TaskHandle_t* handle, BaseType_t) {
+    HostTask* task = new HostTask;
+    if (handle != nullptr) {
+        *handle = task;
+    }
+    std::thread([function, parameter, task] {
+        currentTask = task;
+        try {
+            function(parameter);
+        } catch (const TaskExit&) {
+            // vTaskDelete(NULL) unwinds the task function
+        }
+    }).detach();
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr) {
+        throw TaskExit();
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (currentTask == nullptr) {
+        currentTask = new HostTask;
+    }
+    return currentTask;
+}
+
+TickType_t xTaskGetTickCount() {
+    using namespace std::chrono;
+    return static_cast<TickType_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    HostTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    auto pending = [task] { return task->notifications > 0; };
+    if (ticksToWait == portMAX_DELAY) {
+        task->notified.wait(lock, pending);
+    } else {
+        task->notified.wait_for(lock, std::chrono::milliseconds(ticksToWait), pending);
+    }
+    uint32_t count = task->notifications;
+    if (clearOnExit) {
+        task->notifications = 0;
+    } else if (count > 0) {
+        --task->notifications;
+    }
+    return count;
+}
+
+BaseType_t xPortGetCoreID() {
+    return static_cast<BaseType_t>(threadCore);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        ++task->notifications;
+    }
+    task->notified.notify_one();
+    return pdPASS;
+}
@@ -0,0 +1,244 @@
+/**
+ * @file loggerbench.cpp
+ * @brief Host benchmark suite for Logger with machine-readable output.
+ *
+ * Build from the repository root with any C++17 compiler and ArduinoJson 7
+ * (PlatformIO fetches it into .pio/libdeps):
+ *
+ *   g++ -std=gnu++17 -O2 -Itools/loggerbench/host -Isrc -I.pio/libdeps/nodemcu-32s/ArduinoJson/src \
+ *       -include Arduino.h -o loggerbench tools/loggerbench/loggerbench.cpp tools/loggerbench/host/host.cpp \
+ *       src/ESPLogger.cpp src/ESPLogFormat.cpp src/ESPBraceFormat.cpp -lpthread
+ *
+ * Usage: loggerbench [calls per producer]   (default 20000)
+ *
+ * Add -DLOGGER_DEFERRED_FORMAT or other LOGGER_* flags to measure those
+ * layouts. Every result is one JSON object per line, e.g.
+ *
+ *   {"bench":"log_formatted","producers":2,"observers":0,"calls":40000,"mean_ns":181.2,"p50_ns":176,
+ *    "p99_ns":238,"max_ns":5210,"calls_per_s":4390118,"lost":39520,"busy":0}
+ *
+ * (on a single line), so runs can be stored and compared with jq or a
+ * spreadsheet. "lost" counts entries overwritten before the reader got to
+ * them, "busy" entries dropped because the ring was full of records other
+ * producers were still writing; producers never wait for each other.
+ * Host numbers track relative regressions; LoggerBenchmark.ino measures
+ * the device.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ESPLogger.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t DEFAULT_CALLS = 20000;
+constexpr size_t PRODUCER_COUNTS[] = {1, 2, 4, 8};
+
+std::atomic<size_t> heapBytes{0}; ///< Bytes requested from operator new so far
+
+/// What one benchmarked call logs
+enum class Workload {
+    PLAIN,     ///< Message without formatting
+    FORMATTED, ///< printf format with two arguments
+    BRACE,     ///< "{}" format with two arguments
+    FILTERED,  ///< DEBUG call below the runtime filter level
+};
+
+const char* workloadName(Workload workload) {
+    switch (workload) {
+        case Workload::PLAIN: return "log_plain";
+        case Workload::FORMATTED: return "log_formatted";
+        case Workload::BRACE: return "log_brace";
+        case Workload::FILTERED: return "log_filtered";
+    }
+    return "unknown";
+}
+
+double elapsedNs(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+void drain(Logger& logger) {
+    Logger::LogEntry entry;
+    while (logger.getNextLog(entry)) {
+        // Discard whatever is left in the buffer
+    }
+}
+
+void produce(const Logger::Tag& tag, Workload workload, size_t calls, int id, uint32_t* samples) {
+    Logger& logger = Logger::instance();
+    for (size_t i = 0; i < calls; ++i) {
+        Clock::time_point start = Clock::now();
+        switch (workload) {
+            case Workload::PLAIN:
+                logger.log(tag, Logger::Level::INFO, "producer iteration");
+                break;
+            case Workload::FORMATTED:
+                logger.log(tag, Logger::Level::INFO, "producer %d iteration %u", id, static_cast<unsigned>(i));
+                break;
+            case Workload::BRACE:
+                logger.logFormat(tag, Logger::Level::INFO, "producer {} iteration {}", id, i);
+                break;
+            case Workload::FILTERED:
+                logger.log(tag, Logger::Level::DEBUG, "producer %d iteration %u", id, static_cast<unsigned>(i));
+                break;
+        }
+        samples[i] = static_cast<uint32_t>(elapsedNs(start, Clock::now()));
+    }
+}
+
+/**
+ * @brief Time log() calls from several threads and print one result line.
+ * @param name Value of the "bench" key.
+ * @param workload Call each producer makes.
+ * @param producers Number of producer threads.
+ * @param calls Calls per producer.
+ * @param observers Observers attached, reported as an extra key.
+ */
+void runLatency(const char* name, Workload workload, size_t producers, size_t calls, size_t observers) {
+    Logger& logger = Logger::instance();
+    static const Logger::Tag tag("Bench");
+    drain(logger);
+    const size_t lostBefore = logger.getDroppedCount();
+    const size_t busyBefore = logger.getBusyDroppedCount();
+
+    std::vector<uint32_t> samples(producers * calls);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < producers; ++i) {
+        threads.emplace_back(produce, std::cref(tag), workload, calls, static_cast<int>(i), samples.data() + i * calls);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const double wallNs = elapsedNs(start, Clock::now());
+    // Overwritten entries are counted when the reader catches up
+    drain(logger);
+    const size_t lost = logger.getDroppedCount() - lostBefore;
+    const size_t busy = logger.getBusyDroppedCount() - busyBefore;
+
+    double totalNs = 0;
+    for (uint32_t sample : samples) {
+        totalNs += sample;
+    }
+    std::sort(samples.begin(), samples.end());
+    printf("{\"bench\":\"%s\",\"producers\":%zu,\"observers\":%zu,\"calls\":%zu,\"mean_ns\":%.1f,"
+           "\"p50_ns\":%u,\"p99_ns\":%u,\"max_ns\":%u,\"calls_per_s\":%.0f,\"lost\":%zu,\"busy\":%zu}\n",
+           name, producers, observers, samples.size(), totalNs / samples.size(), samples[samples.size() / 2],
+           samples[samples.size() * 99 / 100], samples.back(), samples.size() / (wallNs / 1e9), lost, busy);
+}
+
+void fill(Logger& logger) {
+    drain(logger);
+    for (size_t i = 0; i < Logger::MAX_LOGS; ++i) {
+        logger.log("Bench", Logger::Level::INFO, "drain entry %u value %d", static_cast<unsigned>(i), -static_cast<int>(i));
+    }
+}
+
+void printDrain(const char* name, size_t entries, size_t bytes, double ns) {
+    printf("{\"bench\":\"%s\",\"entries\":%zu,\"bytes\":%zu,\"total_ns\":%.0f,\"ns_per_entry\":%.1f,\"mb_per_s\":%.2f}\n",
+           name, entries, bytes, ns, entries > 0 ? ns / entries : 0.0, ns > 0 ? bytes / ns * 1e3 : 0.0);
+}
+
+/**
+ * @brief Time emptying a full buffer with getNextLogJson and with exportLogs.
+ */
+void runDrain() {
+    Logger& logger = Logger::instance();
+
+    fill(logger);
+    size_t entries = 0;
+    size_t bytes = 0;
+    Clock::time_point start = Clock::now();
+    for (String json = logger.getNextLogJson(); !json.isEmpty(); json = logger.getNextLogJson()) {
+        bytes += json.length();
+        ++entries;
+    }
+    printDrain("drain_json", entries, bytes, elapsedNs(start, Clock::now()));
+
+    fill(logger);
+    std::vector<char> buffer(Logger::MAX_LOGS * 512);
+    start = Clock::now();
+    entries = logger.exportLogs(buffer.data(), buffer.size(), bytes);
+    printDrain("drain_export", entries, bytes, elapsedNs(start, Clock::now()));
+}
+
+/**
+ * @brief Print the static and heap footprint of the Logger layout.
+ * @param constructionHeap Heap bytes requested while the instance was created.
+ */
+void runMemory(size_t constructionHeap) {
+    printf("{\"bench\":\"memory\",\"capacity\":%zu,\"message_size\":%zu,\"tag_size\":%zu,\"fields_size\":%zu,"
+           "\"logger_bytes\":%zu,\"ring_bytes\":%zu,\"entry_bytes\":%zu,\"construction_heap_bytes\":%zu}\n",
+           Logger::MAX_LOGS, Logger::LOG_SIZE, Logger::TAG_SIZE, Logger::FIELDS_SIZE, sizeof(Logger),
+           Logger::getBufferSize(), sizeof(Logger::LogEntry), constructionHeap);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    heapBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* pointer = malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+int main(int argc, char** argv) {
+    size_t calls = DEFAULT_CALLS;
+    if (argc > 2 || (argc == 2 && (calls = strtoul(argv[1], nullptr, 10)) == 0)) {
+        fprintf(stderr, "usage: %s [calls per producer]\n", argv[0]);
+        return 2;
+    }
+
+    const size_t heapBefore = heapBytes.load();
+    Logger& logger = Logger::instance();
+    runMemory(heapBytes.load() - heapBefore);
+
+    for (Workload workload : {Workload::PLAIN, Workload::FORMATTED, Workload::BRACE}) {
+        for (size_t producers : PRODUCER_COUNTS) {
+            runLatency(workloadName(workload), workload, producers, calls, 0);
+        }
+    }
+
+    logger.setFilterLevel(Logger::Level::INFO);
+    runLatency(workloadName(Workload::FILTERED), Workload::FILTERED, 1, calls, 0);
+    logger.setFilterLevel(Logger::Level::DEBUG);
+
+    std::atomic<size_t> delivered{0};
+    auto observer = [&delivered](std::string_view, Logger::Level, std::string_view message) {
+        delivered.fetch_add(message.size(), std::memory_order_relaxed);
+    };
+    std::vector<Logger::ObserverHandle> handles;
+    for (size_t count = 1; count <= Logger::MAX_OBSERVERS; count *= 2) {
+        while (handles.size() < count) {
+            handles.push_back(logger.addLogObserver(observer));
+        }
+        for (size_t producers : {size_t(1), size_t(4)}) {
+            runLatency("log_observers", Workload::FORMATTED, producers, calls, count);
+        }
+    }
+    for (Logger::ObserverHandle handle : handles) {
+        logger.removeLogObserver(handle);
+    }
+
+    runDrain();
+    return 0;
+}
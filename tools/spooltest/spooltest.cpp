@@ -0,0 +1,356 @@
+/**
+ * @file spooltest.cpp
+ * @brief Host test for ESPMQTTSpool.
+ *
+ * The spool only uses stdio and POSIX directory calls, so no shims are
+ * needed. Build and run from the repository root with any C++17 compiler:
+ *
+ *   g++ -std=gnu++17 -O2 -Isrc -o spooltest tools/spooltest/spooltest.cpp src/MQTTSpool.cpp
+ *   ./spooltest
+ *
+ * Every case works in its own directory under the system temp directory.
+ * Failed checks are printed with their line; the exit status is the number
+ * of failed checks.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "MQTTSpool.h"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+void check(bool passed, const char* text, int line) {
+    if (!passed) {
+        fprintf(stderr, "spooltest.cpp:%d: check failed: %s\n", line, text);
+        ++failures;
+    }
+}
+
+/**
+ * @brief Get a path for one case; the spool creates the directory itself.
+ * @param name Case name, part of the directory name.
+ * @return Path of a directory that does not exist yet.
+ */
+std::string makeDirectory(const char* name) {
+    const char* base = getenv("TMPDIR");
+    std::string pattern = std::string(base != nullptr ? base : "/tmp") + "/spooltest-" + name + "-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+    if (mkdtemp(path.data()) == nullptr) {
+        perror("mkdtemp");
+        exit(1);
+    }
+    rmdir(path.data());
+    return path.data();
+}
+
+std::string segmentPath(const std::string& directory, uint32_t segment) {
+    char path[256];
+    MQTTSpool::segmentPath(path, sizeof(path), directory.c_str(), segment);
+    return path;
+}
+
+bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+long fileSize(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? static_cast<long>(info.st_size) : -1;
+}
+
+/**
+ * @brief Store message number index with topic "test/<index>" and payload "payload <index>".
+ */
+bool appendMessage(ESPMQTTSpool& spool, int index) {
+    char topic[32];
+    char payload[32];
+    snprintf(topic, sizeof(topic), "test/%d", index);
+    int length = snprintf(payload, sizeof(payload), "payload %d", index);
+    return spool.append(topic, reinterpret_cast<const uint8_t*>(payload), length, index % 2 == 0, index % 3 == 0 ? 1 : 0);
+}
+
+/**
+ * @brief Check a message read back against what appendMessage stored.
+ * @return Index of the message, -1 if it does not match.
+ */
+int messageIndex(const ESPMQTTSpool::Message& message) {
+    int index = -1;
+    if (sscanf(message.topic, "test/%d", &index) != 1) {
+        return -1;
+    }
+    char payload[32];
+    int length = snprintf(payload, sizeof(payload), "payload %d", index);
+    bool same = message.length == static_cast<size_t>(length) && memcmp(message.payload, payload, length) == 0 &&
+                message.retained == (index % 2 == 0) && message.qos == (index % 3 == 0 ? 1 : 0);
+    return same ? index : -1;
+}
+
+/**
+ * @brief Peek and consume the next message.
+ * @return Its index, -1 if there is none or it does not match.
+ */
+int takeMessage(ESPMQTTSpool& spool) {
+    ESPMQTTSpool::Message message;
+    if (!spool.peek(message)) {
+        return -1;
+    }
+    spool.consume();
+    return messageIndex(message);
+}
+
+void testAppendAndRead() {
+    std::string directory = makeDirectory("read");
+    ESPMQTTSpool::Config config;
+    config.directory = directory.c_str();
+    ESPMQTTSpool spool(config);
+    CHECK(spool.begin());
+    CHECK(spool.empty());
+
+    for (int i = 0; i < 5; ++i) {
+        CHECK(appendMessage(spool, i));
+    }
+    CHECK(!spool.empty());
+
+    // peek() without consume() returns the same message again
+    ESPMQTTSpool::Message message;
+    CHECK(spool.peek(message) && messageIndex(message) == 0);
+    CHECK(spool.peek(message) && messageIndex(message) == 0 && message.segment == 0 && message.offset == 0);
+    for (int i = 0; i < 5; ++i) {
+        CHECK(takeMessage(spool) == i);
+    }
+    CHECK(!spool.peek(message));
+    CHECK(spool.empty());
+
+    // Messages appended after the reader caught up are still found
+    CHECK(appendMessage(spool, 5));
+    CHECK(takeMessage(spool) == 5);
+
+    // A streamed message is kept only when all announced bytes arrived
+    const uint8_t part[] = {'a', 'b', 'c'};
+    CHECK(spool.beginAppend("test/stream", 6, false, 0));
+    spool.appendData(part, sizeof(part));
+    spool.appendData(part, sizeof(part));
+    CHECK(spool.endAppend(true));
+    CHECK(spool.beginAppend("test/short", 6, false, 0));
+    spool.appendData(part, sizeof(part));
+    CHECK(!spool.endAppend(true));
+    CHECK(spool.beginAppend("test/dropped", 0, false, 0));
+    CHECK(!spool.endAppend(false));
+    CHECK(spool.peek(message) && strcmp(message.topic, "test/stream") == 0 && message.length == 6 &&
+          memcmp(message.payload, "abcabc", 6) == 0);
+    spool.consume();
+    CHECK(!spool.peek(message));
+    CHECK(spool.getCorruptRecordCount() == 0);
+}
+
+void testResume() {
+    std::string directory = makeDirectory("resume");
+    ESPMQTTSpool::Config config;
+    config.directory = directory.c_str();
+    {
+        ESPMQTTSpool spool(config);
+        CHECK(spool.begin());
+        for (int i = 0; i < 6; ++i) {
+            CHECK(appendMessage(spool, i));
+        }
+        CHECK(takeMessage(spool) == 0);
+        CHECK(takeMessage(spool) == 1);
+        CHECK(spool.commit());
+        // Read but not committed, so sent again after the restart
+        CHECK(takeMessage(spool) == 2);
+    }
+    {
+        ESPMQTTSpool spool(config);
+        CHECK(spool.begin());
+        CHECK(takeMessage(spool) == 2);
+        CHECK(takeMessage(spool) == 3);
+
+        // Appends after a restart start a new segment, read after the old one
+        CHECK(appendMessage(spool, 6));
+        CHECK(fileExists(segmentPath(directory, 1)));
+        for (int i = 4; i <= 6; ++i) {
+            CHECK(takeMessage(spool) == i);
+        }
+        CHECK(spool.empty());
+        CHECK(spool.commit());
+        CHECK(!fileExists(segmentPath(directory, 0)));
+    }
+    {
+        ESPMQTTSpool spool(config);
+        CHECK(spool.begin());
+        CHECK(spool.empty());
+        CHECK(takeMessage(spool) == -1);
+    }
+}
+
+void testCommitPosition() {
+    std::string directory = makeDirectory("commit");
+    ESPMQTTSpool::Config config;
+    config.directory = directory.c_str();
+    config.segmentSize = 64;
+    config.maxSegments = 16;
+    {
+        ESPMQTTSpool spool(config);
+        CHECK(spool.begin());
+        for (int i = 0; i < 6; ++i) {
+            CHECK(appendMessage(spool, i));
+        }
+
+        // Read four, but only the first two were delivered
+        std::vector<ESPMQTTSpool::Message> read;
+        for (int i = 0; i < 4; ++i) {
+            ESPMQTTSpool::Message message;
+            CHECK(spool.peek(message) && messageIndex(message) == i);
+            read.push_back(message);
+            spool.consume();
+        }
+        CHECK(read[2].segment > read[0].segment);
+        CHECK(spool.commit(read[2].segment, read[2].offset));
+        CHECK(!fileExists(segmentPath(directory, read[0].segment)));
+        CHECK(fileExists(segmentPath(directory, read[2].segment)));
+
+        // The read cursor is not moved back, and nothing before the first segment can be committed
+        CHECK(takeMessage(spool) == 4);
+        CHECK(!spool.commit(read[0].segment, 0));
+    }
+    {
+        ESPMQTTSpool spool(config);
+        CHECK(spool.begin());
+        for (int i = 2; i < 6; ++i) {
+            CHECK(takeMessage(spool) == i);
+        }
+        CHECK(spool.empty());
+
+        // A position past the read cursor is clamped to it
+        CHECK(spool.commit(1000, 0));
+    }
+    {
+        ESPMQTTSpool spool(config);
+        CHECK(spool.begin());
+        CHECK(spool.empty());
+    }
+}
+
+void testMaxSegments() {
+    std::string directory = makeDirectory("full");
+    ESPMQTTSpool::Config config;
+    config.directory = directory.c_str();
+    config.segmentSize = 32;
+    config.maxSegments = 3;
+    ESPMQTTSpool spool(config);
+    CHECK(spool.begin());
+
+    // Every record is larger than segmentSize, so each takes a segment of its own
+    for (int i = 0; i < 3; ++i) {
+        CHECK(appendMessage(spool, i));
+    }
+    CHECK(!appendMessage(spool, 3));
+    CHECK(!spool.beginAppend("test/full", 4, false, 0));
+    CHECK(!fileExists(segmentPath(directory, 3)));
+
+    // Committing a delivered segment makes room again
+    CHECK(takeMessage(spool) == 0);
+    CHECK(spool.commit());
+    CHECK(!fileExists(segmentPath(directory, 0)));
+    CHECK(appendMessage(spool, 3));
+    CHECK(!appendMessage(spool, 4));
+    for (int i = 1; i < 4; ++i) {
+        CHECK(takeMessage(spool) == i);
+    }
+    CHECK(spool.empty());
+}
+
+void testTornRecord() {
+    std::string directory = makeDirectory("torn");
+    ESPMQTTSpool::Config config;
+    config.directory = directory.c_str();
+    {
+        ESPMQTTSpool spool(config);
+        CHECK(spool.begin());
+        for (int i = 0; i < 3; ++i) {
+            CHECK(appendMessage(spool, i));
+        }
+    }
+
+    // A reset in the middle of the last write leaves part of its record
+    std::string path = segmentPath(directory, 0);
+    CHECK(truncate(path.c_str(), fileSize(path) - 3) == 0);
+    {
+        ESPMQTTSpool spool(config);
+        CHECK(spool.begin());
+        CHECK(appendMessage(spool, 3));
+        CHECK(takeMessage(spool) == 0);
+        CHECK(takeMessage(spool) == 1);
+        CHECK(takeMessage(spool) == 3);
+        CHECK(spool.empty());
+        CHECK(spool.getCorruptRecordCount() == 1);
+    }
+}
+
+void testCorruptRecord() {
+    std::string directory = makeDirectory("crc");
+    ESPMQTTSpool::Config config;
+    config.directory = directory.c_str();
+    ESPMQTTSpool spool(config);
+    CHECK(spool.begin());
+    for (int i = 0; i < 4; ++i) {
+        CHECK(appendMessage(spool, i));
+    }
+
+    ESPMQTTSpool::Message message;
+    CHECK(spool.peek(message) && messageIndex(message) == 0);
+    spool.consume();
+    CHECK(spool.peek(message) && messageIndex(message) == 1);
+    uint32_t damaged = message.offset + sizeof(MQTTSpool::RecordHeader) + 1;
+
+    // Damage a topic byte of the second record in the segment still being written
+    FILE* file = fopen(segmentPath(directory, 0).c_str(), "r+b");
+    CHECK(file != nullptr);
+    if (file != nullptr) {
+        fseek(file, damaged, SEEK_SET);
+        fputc('#', file);
+        fclose(file);
+    }
+
+    // The peeked copy is in RAM; a fresh read finds the bad CRC and skips the rest of the segment
+    spool.consume();
+    CHECK(spool.commit(0, message.offset));
+    {
+        ESPMQTTSpool restarted(config);
+        CHECK(restarted.begin());
+        CHECK(takeMessage(restarted) == -1);
+        CHECK(restarted.getCorruptRecordCount() == 1);
+
+        // Later appends go to a fresh segment and are still delivered
+        CHECK(appendMessage(restarted, 4));
+        CHECK(takeMessage(restarted) == 4);
+        CHECK(restarted.empty());
+    }
+}
+
+} // namespace
+
+int main() {
+    testAppendAndRead();
+    testResume();
+    testCommitPosition();
+    testMaxSegments();
+    testTornRecord();
+    testCorruptRecord();
+
+    if (failures == 0) {
+        printf("spooltest: all checks passed\n");
+    }
+    return failures;
+}